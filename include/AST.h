@@ -1,6 +1,9 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
+#include <memory_resource>
+#include <unordered_map>
 #include "Token.h"
 #include "Object.h"
 
@@ -90,6 +93,42 @@ enum class ASTKind {
 
 namespace AST {
 
+/*
+ * Arena
+ *   allocator of the AST of a script.
+ *
+ *   all nodes and their lists are allocated in contiguous chunks owned by
+ *   the arena, and freed at once with the arena. destructors of nodes are
+ *   never called, so a node must not own any memory outside of the arena.
+ */
+class Arena : public std::pmr::monotonic_buffer_resource {
+public:
+  Arena()
+    : std::pmr::monotonic_buffer_resource(0x10000)
+  {
+  }
+
+  Arena(Arena const&) = delete;
+
+  /*
+   * make a node.
+   * if the node has lists, the arena is passed as the last argument of
+   * the constructor.
+   */
+  template <class T, class... Ts>
+  T* make(Ts&&... args) {
+    auto ptr = this->allocate(sizeof(T), alignof(T));
+
+    if constexpr( std::is_constructible_v<T, Ts&&..., Arena&> )
+      return new (ptr) T(std::forward<Ts>(args)..., *this);
+    else
+      return new (ptr) T(std::forward<Ts>(args)...);
+  }
+};
+
+template <class T>
+using List = std::pmr::vector<T>;
+
 struct Base {
   ASTKind kind;
   Token* token;
@@ -106,23 +145,28 @@ protected:
 };
 
 struct WithName : Base {
-  std::string name;
+  std::string_view name;
+  SymbolID sym;
   Token* nameToken;
 
-  std::string const& getName() const {
+  std::string_view getName() const {
     return this->name;
   }
 
-  WithName(ASTKind kind, std::string const& name)
-    : Base(kind, nullptr),
-      name(name),
-      nameToken(nullptr)
-  {
+  SymbolID getSymbol() const {
+    return this->sym;
+  }
+
+  void setNameToken(Token* tok) {
+    this->name = tok->str;
+    this->sym = tok->sym;
+    this->nameToken = tok;
   }
 
   WithName(ASTKind kind, Token* token, Token* nameToken = nullptr)
     : Base(kind, token),
       name(nameToken ? nameToken->str : token->str),
+      sym(nameToken ? nameToken->sym : token->sym),
       nameToken(nameToken)
   {
   }
@@ -137,10 +181,6 @@ struct Value : Base {
   {
     this->object->noDelete = true;
   }
-
-  ~Value()
-  {
-  }
 };
 
 struct Variable : WithName {
@@ -153,35 +193,23 @@ struct Variable : WithName {
 };
 
 struct Array : Base {
-  std::vector<Base*> elements;
+  List<Base*> elements;
 
-  Array(Token* token, std::vector<Base*> elems = { })
+  Array(Token* token, Arena& arena)
     : Base(ASTKind::Array, token),
-      elements(std::move(elems))
-  {
-  }
-
-  ~Array()
+      elements(&arena)
   {
-    for( auto&& e : this->elements )
-      delete e;
   }
 };
 
 struct Function;
 struct CallFunc : WithName {
-  std::vector<Base*> arguments;
+  List<Base*> arguments;
 
-  CallFunc(Token* token, std::vector<Base*> arguments = { })
+  CallFunc(Token* token, Arena& arena)
     : WithName(ASTKind::CallFunc, token),
-      arguments(std::move(arguments))
-  {
-  }
-
-  ~CallFunc()
+      arguments(&arena)
   {
-    for( auto&& arg : this->arguments )
-      delete arg;
   }
 };
 
@@ -195,28 +223,56 @@ struct Expr : Base {
       right(right)
   {
   }
+};
 
-  ~Expr()
+//
+// IndexRef
+//  --> "obj[index]"
+//
+struct IndexRef : Expr {
+  //
+  // isInBounds:
+  //   true if a range analysis of the enclosing for-loop proved that
+  //   the index never goes out of the object. --> skip bounds check.
+  bool isInBounds;
+
+  IndexRef(Token* token, Base* obj, Base* index)
+    : Expr(ASTKind::IndexRef, token, obj, index),
+      isInBounds(false)
   {
-    delete this->left;
-
-    if( this->right )
-      delete this->right;
   }
 };
 
-struct Scope : Base {
-  std::vector<Base*> list;
-
-  Scope(Token* token)
-    : Base(ASTKind::Scope, token)
+//
+// MemberAccess
+//  --> "obj.name"
+//
+struct MemberAccess : Expr {
+  //
+  // resolved:
+  //   true after "EnumName.Name" is looked up at the first evaluation.
+  //
+  // enumerator:
+  //   the value if it is "EnumName.Name", or nullptr.
+  //
+  bool resolved;
+  objects::Enumerator* enumerator;
+
+  MemberAccess(Token* token, Base* obj, Base* member)
+    : Expr(ASTKind::MemberAccess, token, obj, member),
+      resolved(false),
+      enumerator(nullptr)
   {
   }
+};
+
+struct Scope : Base {
+  List<Base*> list;
 
-  ~Scope()
+  Scope(Token* token, Arena& arena)
+    : Base(ASTKind::Scope, token),
+      list(&arena)
   {
-    for( auto&& x : this->list )
-      delete x;
   }
 };
 
@@ -232,18 +288,11 @@ struct If : Base {
       case_false(nullptr)
   {
   }
-
-  ~If()
-  {
-    delete this->cond;
-    delete this->case_true;
-    delete this->case_false;
-  }
 };
 
 struct Switch : Base {
   struct Case {
-    Base* to_compare;
+    Base* to_compare; // nullptr if "default"
     Base* scope;
 
     Case(Base* to_compare, Base* scope)
@@ -251,49 +300,62 @@ struct Switch : Base {
         scope(scope)
     {
     }
+  };
 
-    ~Case()
-    {
-      delete this->to_compare;
-      delete this->scope;
-    }
+  //
+  // dispatch:
+  //   how to find the case matching with the value.
+  //   decided at first evaluation.
+  //
+  enum class Dispatch {
+    Unknown,
+    Linear,   // compare with each case in order
+    Table,    // dense jump table (keys are small range of int or char)
+    Hash,     // hash table (keys are int or char)
   };
 
   Base* expr;
-  std::vector<Case> cases;
+  List<Case> cases;
+
+  Dispatch dispatch;
+  TypeInfo::Kind keyKind;
+  int64_t tableBase;
+  List<Case*> table;
+  std::pmr::unordered_map<int64_t, Case*> hashTable;
+  Case* defaultCase;
 
   Case& append(Base* to_compare, Base* scope) {
     return this->cases.emplace_back(to_compare, scope);
   }
 
-  Switch(Token* token)
+  Switch(Token* token, Arena& arena)
     : Base(ASTKind::Switch, token),
-      expr(nullptr)
+      expr(nullptr),
+      cases(&arena),
+      dispatch(Dispatch::Unknown),
+      keyKind(TypeInfo::None),
+      tableBase(0),
+      table(&arena),
+      hashTable(&arena),
+      defaultCase(nullptr)
   {
   }
-
-  ~Switch()
-  {
-    delete this->expr;
-  }
 };
 
+//
+// While
+//  --> while, do-while, loop (cond is nullptr)
+//
 struct While : Base {
   Base* cond;
   Base* code;
 
-  While(Token* token)
-    : Base(ASTKind::While, token),
+  While(Token* token, ASTKind kind = ASTKind::While)
+    : Base(kind, token),
       cond(nullptr),
       code(nullptr)
   {
   }
-
-  ~While()
-  {
-    delete this->cond;
-    delete this->code;
-  }
 };
 
 struct For : Base {
@@ -301,41 +363,51 @@ struct For : Base {
   Base* content;
   Base* code;
 
+  // already ran the range analysis for bounds-check elimination
+  bool isAnalyzed;
+
   For(Token* token)
     : Base(ASTKind::For, token),
       iter(nullptr),
       content(nullptr),
-      code(nullptr)
+      code(nullptr),
+      isAnalyzed(false)
   {
   }
-
-  ~For()
-  {
-    delete this->iter;
-    delete this->content;
-    delete this->code;
-  }
 };
 
 struct Function : Base {
   Token* name_token;
-  std::vector<Token*> arguments;
+  List<Token*> arguments;
+
+  //
+  // scope:
+  //   nullptr until the body is parsed at first call (lazy parsing).
+  //   "body" is the '{' token of the body, "arena" is the arena to
+  //   allocate the body in, and "constants" is the constant pool of
+  //   the script.
   Scope* scope;
+  Token* body;
+  Arena* arena;
+  ConstantPool const* constants;
 
   std::string_view getName() const {
     return this->name_token->str;
   }
 
-  Function(Token* token)
-    : Base(ASTKind::Function, token),
-      name_token(nullptr),
-      scope(nullptr)
-  {
+  SymbolID getSymbol() const {
+    return this->name_token->sym;
   }
 
-  ~Function()
+  Function(Token* token, Arena& arena)
+    : Base(ASTKind::Function, token),
+      name_token(nullptr),
+      arguments(&arena),
+      scope(nullptr),
+      body(nullptr),
+      arena(&arena),
+      constants(nullptr)
   {
-    delete this->scope;
   }
 };
 
@@ -349,29 +421,41 @@ struct IdentifierList : WithName {
   }
 
 protected:
-  IdentifierList(ASTKind kind, Token* token, Token* nametok)
-    : WithName(kind, token, nametok)
+  IdentifierList(ASTKind kind, Token* token, Token* nametok, Arena& arena)
+    : WithName(kind, token, nametok),
+      _idents(&arena)
   {
   }
 
-  std::vector<Token*> _idents;
+  List<Token*> _idents;
 };
 
 struct Enum : IdentifierList {
-  std::vector<Token*>& enumerators;
+  List<Token*>& enumerators;
 
-  Enum(Token* token, Token* nametok)
-    : IdentifierList(ASTKind::Enum, token, nametok),
-      enumerators(this->_idents)
+  // unique id of this enum. tags the values of enumerators.
+  uint32_t id;
+
+  // the value of each enumerator. made by evaluator, shared by all uses.
+  List<objects::Enumerator*> values;
+
+  Enum(Token* token, Token* nametok, Arena& arena)
+    : IdentifierList(ASTKind::Enum, token, nametok, arena),
+      enumerators(this->_idents),
+      id(_id_counter++),
+      values(&arena)
   {
   }
+
+private:
+  static inline std::atomic<uint32_t> _id_counter;
 };
 
 struct Struct : IdentifierList {
-  std::vector<Token*>& members;
+  List<Token*>& members;
 
-  Struct(Token* token, Token* nametok)
-    : IdentifierList(ASTKind::Struct, token, nametok),
+  Struct(Token* token, Token* nametok, Arena& arena)
+    : IdentifierList(ASTKind::Struct, token, nametok, arena),
       members(this->_idents)
   {
   }
@@ -15,6 +15,7 @@ struct BuiltinFunc {
   using FuncPointer = std::function<Object*(AST::CallFunc*, std::vector<Object*>&)>;
 
   std::string   name;
+  SymbolID      sym;
   bool          have_self;
   TypeInfo      self_type;
   FuncPointer   impl;
@@ -26,6 +27,7 @@ struct BuiltinFunc {
 
   BuiltinFunc(std::string const& name, FuncPointer impl)
     : name(name),
+      sym(SymbolTable::get(name)),
       have_self(false),
       impl(impl)
   {
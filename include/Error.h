@@ -45,6 +45,25 @@ public:
 
   static void check();
 
+  // thrown by exit() in the scope of Defer
+  struct Aborted { };
+
+  //
+  // Defer
+  //   in the scope, exit() throws Aborted instead of exiting, so that the
+  //   threads loading modules stop their work, and the main thread exits
+  //   by check() after joining them. (exit() in a thread destroys static
+  //   objects while the other threads are using them.)
+  //
+  class Defer {
+  public:
+    Defer();
+    ~Defer();
+
+  private:
+    bool saved;
+  };
+
 private:
 
   ErrorLocation location;
@@ -2,6 +2,7 @@
 
 #include <map>
 #include <list>
+#include <unordered_map>
 #include "AST.h"
 #include "Object.h"
 
@@ -9,32 +10,30 @@ namespace metro {
 
 class Evaluator {
   using Object = objects::Object;
-  using Storage = std::map<std::string_view, Object*>;
+  using Storage = std::map<SymbolID, Object*>;
 
   struct CallStack {
     AST::Function const* func;
     Object*   result;
     Storage   storage;
-    bool      isReturned;
 
     CallStack(AST::Function const* func)
       : func(func),
-        result(nullptr),
-        isReturned(false)
+        result(nullptr)
     {
     }
   };
 
-  struct ScopeEvaluationFlags {
-    //
-    // isSkipped:
-    //   if used "return" or "break" or "continue" --> true
-    bool isSkipped = false;
-
-    //
-    // loop flags
-    bool isBreaked    = false;
-    bool isContinued  = false;
+  //
+  // Interrupt:
+  //   set by "break", "continue" or "return".
+  //   a scope stops the evaluation as soon as this is not None,
+  //   and the loop or function that handles it resets to None.
+  enum class Interrupt : uint8_t {
+    None,
+    Break,
+    Continue,
+    Return,
   };
 
 public:
@@ -65,16 +64,72 @@ public:
    */
   Object* evalOperator(AST::Expr* expr);
 
+
+  /*
+   * Evaluate an assignment.
+   * returns the object held by the destination, not a copy.
+   */
+  Object* evalAssignment(AST::Expr* assign);
+
+
+  /*
+   * Evaluate the statement "s = s + x" as appending x to s in place.
+   * returns false if not this form.
+   */
+  bool evalSelfAppend(AST::Expr* assign);
+
+
+  /*
+   * Evaluate a node as condition of "if", "while", "&&", "||" or "!".
+   * if the result isn't boolean, show error.
+   */
+  bool evalCondition(AST::Base* ast);
+
+
+  /*
+   * Call the user-defined function "name" with "args".
+   * used by builtin functions taking a function (ex. sort_by).
+   * "ast" is the location of errors.
+   */
+  Object* callFunction(AST::CallFunc* ast, SymbolID name, std::vector<Object*>& args);
+
 private:
 
-  Object*& evalIndexRef(AST::Expr* ast, Object* obj, Object* index);
+  /*
+   * Evaluate a node only for reading the result.
+   * a variable is returned without clone, so never modify the result.
+   */
+  Object* evalOperand(AST::Base* ast);
+
+  Object*& evalIndexRef(AST::IndexRef* ast, Object* obj, Object* index);
+
+  // type and bounds checked index
+  size_t evalIndex(AST::IndexRef* ast, Object* obj, Object* index);
 
   Object* evalCallFunc(AST::CallFunc* ast, Object* self, std::vector<Object*>& args);
 
+  Object* callUserFunc(AST::CallFunc* ast, AST::Function* func, std::vector<Object*>& args);
+
+  /*
+   * Range analysis for "for i in 0 .. v.count"
+   *   mark "v[i]" in the loop body as in bounds if neither "i" nor "v" is
+   *   rebound there.
+   */
+  void analyzeLoopBounds(AST::For* ast);
+
+  /*
+   * Build the jump table of switch-statement.
+   */
+  void analyzeSwitch(AST::Switch* ast);
+
   CallStack& push_stack(AST::Function const* func);
   void pop_stack();
 
-  ScopeEvaluationFlags& getCurrentScope();
+  /*
+   * check the interrupt after evaluated the body of a loop.
+   * returns true if the loop must be exited.
+   */
+  bool isLoopInterrupted();
 
   bool inFunction() const;
 
@@ -82,7 +137,7 @@ private:
 
   Storage& getCurrentStorage();
 
-  Object** findVariable(std::string_view name, bool allowCreate = true);
+  Object** findVariable(SymbolID name, bool allowCreate = true);
 
 
   /*
@@ -92,22 +147,35 @@ private:
       Find the function just matching same name.
       
    */
-  std::tuple<AST::Function const*, builtin::BuiltinFunc const*> findFunction(std::string_view name, Object* self);
+  std::tuple<AST::Function*, builtin::BuiltinFunc const*> findFunction(SymbolID name, Object* self);
 
   /*
     -- findStruct() --
    */
-  AST::Struct const* findStruct(std::string_view name);
+  AST::Struct const* findStruct(SymbolID name);
+
+  /*
+    -- findEnumerator() --
+
+    about:
+      Resolve "EnumName.Enumerator".
+      returns nullptr if left side is not a name of enum.
+      the result is kept in "ast", so it is looked up only once.
+   */
+  objects::Enumerator* findEnumerator(AST::MemberAccess* ast);
 
 
   AST::Scope* rootScope;
 
+  std::unordered_map<SymbolID, AST::Enum*> enums;
+
   Storage  globalStorage;
   std::vector<CallStack> callStacks;
 
-  ScopeEvaluationFlags* _loopScope;
-  ScopeEvaluationFlags* _funcScope;
-  ScopeEvaluationFlags* _scope;
+  Interrupt interrupt;
+
+  // an element of string or bytes returned by evalIndexRef()
+  Object* elementRef;
 };
 
 } // namespace metro
\ No newline at end of file
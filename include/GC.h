@@ -16,6 +16,12 @@ void initialize();
  */
 bool isEnabled();
 
+/*
+ * The maximum count of objects alive.
+ * "out of memory" if more.
+ */
+size_t maxObjectCount();
+
 void bind(Object*);
 void unbind(Object*);
 
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace metro::objects {
+  struct Object;
+}
+
+namespace metro::json {
+
+//
+// parse
+//   parse a JSON text to objects:
+//     object --> dict, array --> vector, string --> string,
+//     integer --> int (float if too large), number --> float,
+//     true / false --> bool, null --> none
+//
+//   parsed in two stages: first, the positions of all structural
+//   characters are indexed by a SIMD scan of the text, and then the
+//   objects are built by walking the index.
+//
+//   returns nullptr and sets "error" if the text is invalid.
+//
+objects::Object* parse(std::u16string_view text, std::string& error);
+
+//
+// parse the value at "pointer" (JSON Pointer, e.g. "/users/0/name").
+// other values are skipped on the index without building objects, and
+// they are not checked except the brackets.
+//
+// returns nullptr if not found, and sets "error" if the text is invalid.
+//
+objects::Object* parse(std::u16string_view text, std::u16string_view pointer, std::string& error);
+
+//
+// stringify
+//   append the JSON text of "obj" to "out", without spaces.
+//   tuple --> array, struct --> object, char and string_builder --> string.
+//
+//   returns false and sets "error" if "obj" can not be converted.
+//
+bool stringify(std::u16string& out, objects::Object const* obj, std::string& error);
+
+} // namespace metro::json
@@ -1,28 +1,44 @@
 #pragma once
 
-#include <functional>
 #include "Token.h"
+#include "Object.h"
 
 namespace metro {
 
 class Lexer {
 public:
-  Lexer(SourceLoc const&);
+  Lexer(SourceLoc const& src, ConstantPool& constants);
   ~Lexer();
 
-  Token* lex();
+  TokenList lex();
 
 private:
   bool check();
-  char peek();
-  bool match(std::string_view s);
+  char peek(size_t offset = 0);
   size_t pass_space();
-  size_t pass_while(std::function<bool(char)> cond);
+  size_t pass_while(uint8_t charClass);
+  SymbolID match_punctuater();
 
-  std::string_view eat_literal(char quat);
+  bool eat_literal(char quat);
+
+  //
+  // decode literals.
+  // "pos" is the position of the token, used for error.
+  //
+  template <class T>
+  T decode_integer(std::string_view str, int base, size_t pos);
+
+  double decode_float(std::string_view str, size_t pos);
+  std::u16string decode_string(std::string_view str, size_t pos);
+
+  uint32_t add_constant(objects::Object* obj);
+
+  [[noreturn]]
+  void error(size_t pos, std::string const& msg);
 
   SourceLoc const& loc;
-  std::string const& source;
+  ConstantPool& constants;
+  std::string_view source;
   size_t position;
 };
 
@@ -2,23 +2,19 @@
 
 #include <string>
 #include <vector>
+#include <list>
+#include <unordered_map>
 #include "SourceLoc.h"
+#include "AST.h"
 
-namespace metro {
-
-struct Token;
-
-namespace AST {
-  struct Base;
-}
+#define METRO_VERSION "0.0.1"
 
-namespace objects {
-  struct Object;
-}
+namespace metro {
 
 class Lexer;
 class Parser;
 class Error;
+class Evaluator;
 
 /*
  * Metro driver.
@@ -28,10 +24,15 @@ class Metro {
 public:
   struct ScriptInfo {
     SourceLoc  source;
-    
-    Token*            token;
+    uint64_t   hash;    // hash of the source text
+
+    TokenList         tokens;
+    ConstantPool      constants;  // values of literals
+    AST::Arena        arena;  // owns "ast"
     AST::Base*        ast;
     objects::Object*  result;
+
+    // imported modules in order, owned by Metro::modules
     std::vector<ScriptInfo*> _imported;
 
     ScriptInfo(std::string const& path);
@@ -45,6 +46,9 @@ public:
 
   ScriptInfo* getRunningScript();
 
+  // the evaluator running now
+  Evaluator* getEvaluator();
+
   //
   // emit fatal error and exit with code 1.
   [[noreturn]]
@@ -56,17 +60,50 @@ private:
 
   void evaluateScript(ScriptInfo& script);
 
+  //
+  // lex and parse "script" and all modules imported from it.
+  // modules are loaded only once and shared by all importers.
+  //
+  void loadScript(ScriptInfo& script);
+
+  //
+  // get the module at "path" from the cache, or create it if not loaded.
+  // returns the module and true if it's created now.
+  //
+  std::pair<ScriptInfo*, bool> getModule(std::string const& path);
+
+  //
+  // put the definitions of imported modules before the ones of "script".
+  // each module is included once even if imported from several scripts.
+  //
+  void linkImports(ScriptInfo& script);
+
   void parseArguments();
 
   std::vector<std::string> args;
-  std::vector<ScriptInfo> scripts;
+  std::list<ScriptInfo> scripts;
+
+  //
+  // imported modules, keyed by canonical path.
+  // a file is read only once in a run, so the content of a path never
+  // differs, and the hash of the source is not needed in the key.
+  // (it is used to validate the compiled cache, see ScriptCache.h)
+  //
+  std::list<ScriptInfo> modules;
+  std::unordered_map<std::string, ScriptInfo*> moduleCache;
 
   ScriptInfo* currentScript;
+  Evaluator* currentEvaluator;
+
+  // use compiled cache (*.metroc) of scripts
+  bool useCache;
+
+  // parse the bodies of all functions before evaluation
+  bool eagerParse;
 
   static std::vector<Error> emittedErrors; /* in Error.cpp */
 
   friend class Error;
-  friend class Parser;
 };
 
 } // namespace metro
\ No newline at end of file
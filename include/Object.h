@@ -1,9 +1,16 @@
 #pragma once 
 
+#include <memory>
 #include <codecvt>
 #include <locale>
+#include "Symbol.h"
 #include "TypeInfo.h"
 #include "Utils.h"
+#include "Regex.h"
+
+namespace metro {
+  class Output;
+}
 
 namespace metro::objects {
 
@@ -30,6 +37,15 @@ struct Object {
   bool isNumeric() const;
   bool equals(Object* object) const;
 
+  //
+  // compare:
+  //   total order of objects, used by sort.
+  //   numbers are compared by value even if the types are different, and
+  //   other objects of different types are ordered by the kind of type.
+  //   returns negative, zero or positive.
+  //
+  int compare(Object const* object) const;
+
   virtual std::string to_string() const = 0;
   virtual Object* clone() const = 0;
 
@@ -113,18 +129,22 @@ struct _Primitive<bool, TypeInfo::Bool> : Object {
   }
 };
 
+//
+// String
+//  UTF-16 characters are stored in place, not as Char objects.
+//  s[i] makes a new Char, and s[i] = c is handled by assignment.
+//
 template <>
 struct _Primitive<std::u16string, TypeInfo::String> : Object {
-  std::vector<Char*> value;
+  std::u16string value;
 
   std::string to_string() const;
   String* clone() const;
 
   bool equals(String*) const;
 
-  _Primitive(std::u16string const& str = u"");
-  _Primitive(std::string const& str);
-  _Primitive(std::vector<Char*> val);
+  _Primitive(std::u16string val = u"");
+  _Primitive(std::string_view str);   // UTF-8
 
   String* append(Char* ch);
   String* append(String* str);
@@ -156,6 +176,45 @@ struct _Primitive<char16_t, TypeInfo::Char> : Object {
   }
 };
 
+//
+// Enumerator
+//  a value of enum.
+//  only one object is made for each enumerator and shared, so using it
+//  never allocates. never modify it.
+//
+struct Enumerator : Object {
+  uint32_t index;
+
+  AST::Enum const* getEnum() const {
+    return this->type.ast_enum;
+  }
+
+  /*
+   * getKey():
+   *   the immediate integer of this value, tagged with the id of enum.
+   *   unique in all enumerators. (used as key of switch)
+   */
+  int64_t getKey() const;
+
+  std::string to_string() const;
+
+  Enumerator* clone() const {
+    return const_cast<Enumerator*>(this);
+  }
+
+  bool equals(Enumerator* e) const {
+    return this->type.ast_enum == e->type.ast_enum && this->index == e->index;
+  }
+
+  Enumerator(AST::Enum const* ast, uint32_t index)
+    : Object(TypeInfo::Enumerator),
+      index(index)
+  {
+    this->type.ast_enum = ast;
+    this->noDelete = true;
+  }
+};
+
 //
 // Vector
 //  --> vector, struct
@@ -180,7 +239,7 @@ struct Vector : Object {
    *   find the member with name
    *   only can use in TypeInfo::Struct
    */
-  Object** getMember(std::string const& name);
+  Object** getMember(SymbolID name);
 
   Vector(std::vector<Object*> elements = { })
     : Object(TypeInfo::Vector),
@@ -199,28 +258,9 @@ struct Dict : Object {
     return this->elements.emplace_back(key, value);
   }
 
-  std::string to_string() const {
-    if( this->elements.empty() )
-      return "{}";
-    
-    std::string ret = "{";
-
-    for( auto it = this->begin(); it != this->end(); it++ ){
-      ret += it->first->to_string() + ": " + it->second->to_string();
-      if( *it == *this->elements.rbegin() ) ret += ", ";
-    }
-
-    return ret + '}';
-  }
-
-  Dict* clone() const {
-    auto dict = new Dict();
-
-    for( auto&& [k, v] : this->elements )
-      dict->append(k->clone(), v->clone());
+  std::string to_string() const;
 
-    return dict;
-  }
+  Dict* clone() const;
 
   bool equals(Dict* dict) const {
     if( this->elements.size() != dict->elements.size() )
@@ -246,16 +286,7 @@ struct Dict : Object {
 struct Tuple : Object {
   std::vector<Object*> elements;
 
-  std::string to_string() const {
-    std::string ret = "(";
-
-    for( auto&& e : this->elements ) {
-      ret += e->to_string();
-      if( e != *this->elements.rbegin() ) ret += ", ";
-    }
-
-    return ret + ')';
-  }
+  std::string to_string() const;
 
   Tuple* clone() const {
     auto tuple = new Tuple({ });
@@ -288,9 +319,7 @@ struct Pair : Object {
   Object* first;
   Object* second;
 
-  std::string to_string() const {
-    return first->to_string() + ": " + second->to_string();
-  }
+  std::string to_string() const;
 
   Pair* clone() const {
     return new Pair(this->first->clone(), this->second->clone());
@@ -314,9 +343,7 @@ struct Range : Object {
   int64_t begin;
   int64_t end;
 
-  std::string to_string() const {
-    return utils::format("%llu .. %llu", this->begin, this->end);
-  }
+  std::string to_string() const;
 
   Range* clone() const {
     return new Range(this->begin, this->end);
@@ -334,5 +361,215 @@ struct Range : Object {
   }
 };
 
+//
+// Bytes
+//  contiguous buffer of bytes.
+//  elements are not objects, so this is never traced by GC.
+//
+//  the buffer is shared by clones (copy on write), since variables are
+//  cloned at each use.
+//
+struct Bytes : Object {
+  std::shared_ptr<std::vector<uint8_t>> buffer;
+
+  std::vector<uint8_t> const& get() const {
+    return *this->buffer;
+  }
+
+  // the buffer to modify. copied if shared.
+  std::vector<uint8_t>& getMutable() {
+    if( this->buffer.use_count() > 1 )
+      this->buffer = std::make_shared<std::vector<uint8_t>>(*this->buffer);
+
+    return *this->buffer;
+  }
+
+  std::string to_string() const;
+
+  Bytes* clone() const {
+    return new Bytes(this->buffer);
+  }
+
+  bool equals(Bytes* bytes) const {
+    return this->get() == bytes->get();
+  }
+
+  //
+  // read / write an unsigned integer of "size" bytes at "offset".
+  // the range must be checked before.
+  //
+  uint64_t readInt(size_t offset, size_t size, bool bigEndian) const;
+  void writeInt(size_t offset, size_t size, bool bigEndian, uint64_t value);
+
+  //
+  // the position of "needle" in [begin, end), or -1 if not found.
+  //
+  int64_t find(Bytes const* needle, size_t begin = 0) const;
+
+  // same as memcmp. returns -1, 0 or 1
+  int compare(Bytes const* bytes) const;
+
+  Bytes(std::vector<uint8_t> val = { })
+    : Object(TypeInfo::Bytes),
+      buffer(std::make_shared<std::vector<uint8_t>>(std::move(val)))
+  {
+  }
+
+  Bytes(std::shared_ptr<std::vector<uint8_t>> buffer)
+    : Object(TypeInfo::Bytes),
+      buffer(std::move(buffer))
+  {
+  }
+};
+
+//
+// StringBuilder
+//  a string to be built by appending pieces.
+//  "sb + x" appends the text of x in place and returns sb, so building
+//  a string of length n takes O(n) in total.
+//  shared by copies, same as file.
+//
+struct StringBuilder : Object {
+  std::u16string value;
+
+  std::string to_string() const;
+
+  StringBuilder* clone() const {
+    return const_cast<StringBuilder*>(this);
+  }
+
+  bool equals(StringBuilder* sb) const {
+    return this->value == sb->value;
+  }
+
+  // append the text of "obj"
+  StringBuilder* append(Object const* obj);
+
+  // append the text of "obj" to "dest"
+  static void appendText(std::u16string& dest, Object const* obj);
+
+  StringBuilder(std::u16string val = u"")
+    : Object(TypeInfo::StringBuilder),
+      value(std::move(val))
+  {
+  }
+};
+
+//
+// Regex
+//  a regular expression compiled by regex().
+//  the compiled pattern is shared by copies.
+//
+struct Regex : Object {
+  std::u16string pattern;
+  std::shared_ptr<regex::Pattern> compiled;
+
+  std::string to_string() const;
+
+  Regex* clone() const {
+    return new Regex(this->pattern, this->compiled);
+  }
+
+  bool equals(Regex* re) const {
+    return this->pattern == re->pattern;
+  }
+
+  Regex(std::u16string pattern, std::shared_ptr<regex::Pattern> compiled)
+    : Object(TypeInfo::Regex),
+      pattern(std::move(pattern)),
+      compiled(std::move(compiled))
+  {
+  }
+};
+
+//
+// File
+//  a file opened by open().
+//  writes are buffered, and flushed when closed.
+//  the handle is shared by copies, and closed when deleted by GC.
+//
+struct File : Object {
+  enum class Mode {
+    Read,
+    Write,
+    Append,
+  };
+
+  std::string path;
+  Mode mode;
+  int fd;       // -1 if closed
+  Output* out;  // writer (not read mode)
+
+  bool isOpen() const {
+    return this->fd >= 0;
+  }
+
+  bool isWritable() const {
+    return this->isOpen() && this->mode != Mode::Read;
+  }
+
+  // returns false if failed
+  bool open();
+  void close();
+
+  std::string to_string() const {
+    return "<file '" + this->path + "'>";
+  }
+
+  File* clone() const {
+    return const_cast<File*>(this);
+  }
+
+  bool equals(File* file) const {
+    return this == file;
+  }
+
+  File(std::string const& path, Mode mode)
+    : Object(TypeInfo::File),
+      path(path),
+      mode(mode),
+      fd(-1),
+      out(nullptr)
+  {
+  }
+
+  ~File();
+};
+
+//
+// Lines
+//  the lines of a file, made by read_lines().
+//  the file is read lazily while iterating by "for", only one line at a time.
+//
+struct Lines : Object {
+  std::string path;
+  File* file;   // read from this if not null, instead of path
+
+  std::string to_string() const {
+    return "<lines of '" + (this->file ? this->file->path : this->path) + "'>";
+  }
+
+  Lines* clone() const {
+    return const_cast<Lines*>(this);
+  }
+
+  bool equals(Lines* lines) const {
+    return this == lines;
+  }
+
+  Lines(std::string const& path)
+    : Object(TypeInfo::Lines),
+      path(path),
+      file(nullptr)
+  {
+  }
+
+  Lines(File* file)
+    : Object(TypeInfo::Lines),
+      file(file)
+  {
+  }
+};
+
 } // namespace metro::objects
 
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace metro {
+
+namespace objects {
+  struct Object;
+}
+
+//
+// Output
+//   buffered writer to a file descriptor or a string.
+//   the buffer is written out with write(2) (or appended to the string)
+//   when it is full, when a newline is written in line buffering mode,
+//   or when flush() is called.
+//
+class Output {
+public:
+  enum class Mode {
+    Line,   // flush at each newline
+    Full,   // flush only when full
+  };
+
+  static constexpr size_t BufferSize = 0x10000;
+
+  Output(int fd, Mode mode);
+  Output(std::string& dest);
+  ~Output();
+
+  Output(Output const&) = delete;
+
+  Output& write(std::string_view str);
+  Output& write(std::u16string_view str);   // --> UTF-8
+  Output& write(int64_t value);
+  Output& write(uint64_t value);
+  Output& write(double value);              // same as std::to_string()
+
+  Output& put(char c);
+  Output& putChar(char32_t cp);             // --> UTF-8
+
+  //
+  // write the text of an object.
+  // containers are written element by element into the buffer, without
+  // building the strings of elements. a container which is already being
+  // written (= cycle) is written as "[...]".
+  //
+  Output& write(objects::Object const* obj);
+
+  //
+  // the text of an object.
+  // to_string() of containers is implemented with this.
+  //
+  static std::string toString(objects::Object const* obj);
+
+  void flush();
+
+  void setMode(Mode mode) {
+    this->mode = mode;
+  }
+
+  // total bytes written to this output, including buffered bytes
+  size_t getCount() const {
+    return this->count + this->length;
+  }
+
+  //
+  // the stdout of the current thread.
+  // each thread has own buffer, and it is flushed at the end of the thread.
+  //
+  static Output& getStdout();
+
+  //
+  // flush the stdout of all threads.
+  // called by fatal errors, and at exit(3) from any thread.
+  //
+  static void flushAll();
+
+  //
+  // buffering mode of stdout.
+  // line buffering if stdout is a terminal, otherwise full by default.
+  //
+  static void setStdoutMode(Mode mode);
+
+private:
+  // make space for "size" bytes at least
+  char* reserve(size_t size);
+
+  void commit(char* end);
+
+  template <class F>
+  void writeElements(size_t count, F&& writeAt);
+
+  int fd;
+  std::string* dest;
+  Mode mode;
+
+  size_t count;     // bytes already written
+  size_t length;    // bytes in buffer
+  bool needFlush;   // a newline is written in line mode
+
+  // containers being written
+  std::vector<objects::Object const*> active;
+
+  char buffer[BufferSize];
+};
+
+} // namespace metro
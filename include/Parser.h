@@ -6,44 +6,57 @@ namespace metro {
 
 class Parser {
 public:
-  Parser(Token* token);
+  //
+  // isEager:
+  //   parse the bodies of functions immediately.
+  //   if false, only the braces are matched and the body is parsed at
+  //   first call by parseFunctionBody().
+  //
+  Parser(TokenList& tokens, ConstantPool const& constants, AST::Arena& arena,
+    bool isEager = false);
 
   AST::Base* parse();
 
   AST::Base* factor();
   AST::Base* indexref();
   AST::Base* unary();
-  AST::Base* mul();
-  AST::Base* add();
-  AST::Base* shift();
-  AST::Base* range();
-  AST::Base* pair();
-  AST::Base* compare();
-  AST::Base* equality();
-  AST::Base* bitAND();
-  AST::Base* bitOR();
-  AST::Base* bitXOR();
-  AST::Base* logAND();
-  AST::Base* logOR();
-  AST::Base* assign();
+  AST::Base* binary(int minPrec);
   AST::Base* expr();
   AST::Base* stmt();
 
+  static AST::Scope* parseFunctionBody(AST::Function* func);
+
 private:
+  Parser(Token* begin, ConstantPool const& constants, AST::Arena& arena, bool isEager);
+
   bool check();
   Token* next();
   
-  bool eat(std::string_view);
-  Token* expect(std::string_view);
+  bool eat(SymbolID sym);
+  Token* expect(SymbolID sym);
 
   Token* expectIdentifier();
   AST::Scope* expectScope();
 
+  // skip a scope only matching the braces
+  Token* skipScope();
+
+  // parse a statement as the body of loop
+  AST::Base* loopBody();
+
   AST::Variable* newVariable(std::string const& name);
   AST::Expr* newAssign(AST::Base* dest, AST::Base* src);
 
+  ConstantPool const& constants;
+  AST::Arena& arena;
+
+  Token* begin;
   Token* token;
   Token* ate;
+
+  size_t loopDepth;
+
+  bool isEager;
 };
 
 } // namespace metro
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace metro::regex {
+
+//
+// Pattern
+//   a compiled regular expression.
+//
+//   the pattern is compiled to an NFA, and matched by DFAs which are built
+//   lazily from it while matching, so "match" and "search" are linear to
+//   the text. matches are leftmost-longest (POSIX), and there is no back
+//   reference.
+//
+//   syntax:
+//     literal, ".", [set], [^set], (...), (?:...), a|b, *, +, ?,
+//     {n}, {n,}, {n,m}, ^, $,
+//     \d \w \s \D \W \S \n \t \r \f \v \0 \xHH \uHHHH
+//
+//   a character is a UTF-16 code unit. not thread-safe, since the DFAs
+//   are built while matching.
+//
+class Pattern {
+public:
+  //
+  // compile "pattern".
+  // returns nullptr and sets "error" if the pattern is invalid.
+  //
+  static std::shared_ptr<Pattern> compile(std::u16string_view pattern, std::string& error);
+
+  // true if whole of "str" matches
+  bool match(std::u16string_view str);
+
+  //
+  // the leftmost-longest match at "begin" or after.
+  // returns false if not found.
+  //
+  bool search(std::u16string_view str, size_t begin, size_t& matchBegin, size_t& matchEnd);
+
+  //
+  // all matches not overlapped, from the beginning.
+  // the end of each match is found by a forward scan, which may run to
+  // the end of the text before it ends (e.g. "a*b|aa" on "aaa..."), so
+  // the worst case is O(n * matches).
+  //
+  std::vector<std::pair<size_t, size_t>> findAll(std::u16string_view str);
+
+  Pattern(Pattern const&) = delete;
+  ~Pattern();
+
+  // defined in Regex.cpp
+  struct Program;
+  class DFA;
+
+private:
+  Pattern();
+
+  // end of the longest match at "begin", or -1
+  int64_t longest(std::u16string_view str, size_t begin);
+
+  //
+  // true for each position where a match starts.
+  // (computed by one reverse scan)
+  //
+  std::vector<bool> startPositions(std::u16string_view str, size_t begin);
+
+  // where to start scanning from. npos if no match
+  size_t firstCandidate(std::u16string_view str, size_t begin);
+
+  std::unique_ptr<Program> forward;
+  std::unique_ptr<Program> reverse;
+
+  std::unique_ptr<DFA> forwardDFA;    // anchored
+  std::unique_ptr<DFA> reverseDFA;    // unanchored
+
+  // every match starts with this
+  std::u16string prefix;
+
+  // starts with "^"
+  bool anchoredBegin;
+};
+
+} // namespace metro::regex
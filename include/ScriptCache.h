@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Metro.h"
+
+namespace metro::cache {
+
+/*
+ * compiled cache of a script. ("foo.metro" --> "foo.metroc")
+ *
+ *   the constants, tokens and AST of a script are saved next to the source, and loaded
+ *   instead of lexing and parsing while the source and the interpreter are
+ *   not changed.
+ */
+
+std::string getCachePath(std::string const& path);
+
+/*
+ * load the tokens and AST of "script" from the cache.
+ * "script.hash" must be computed before.
+ * returns false if the cache is not found or outdated.
+ */
+bool load(Metro::ScriptInfo& script);
+
+/*
+ * save the tokens and AST of "script".
+ * nothing is done if can't write the cache.
+ */
+void save(Metro::ScriptInfo const& script);
+
+} // namespace metro::cache
@@ -1,15 +1,39 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <mutex>
+#include "Utils.h"
 
 namespace metro {
 
 struct SourceLoc {
   std::string path;
-  std::string data;
 
-  SourceLoc();
+  // the source file mapped read-only.
+  // tokens refer the text directly, so never be unmapped while the script is alive.
+  utils::MappedFile file;
+  std::string_view data;
+
   SourceLoc(std::string const& path);
+
+  //
+  // index of the line including "pos". (0-based)
+  //
+  size_t getLineIndex(size_t pos) const;
+
+  // the offset of first character of the line
+  size_t getLineBegin(size_t index) const;
+
+  // the offset of '\n' at the end of the line, or the length of data
+  size_t getLineEnd(size_t index) const;
+
+private:
+  std::vector<size_t> const& getLineOffsets() const;
+
+  // the offsets of the beginning of each line, built at first use.
+  mutable std::vector<size_t> lineOffsets;
+  mutable std::once_flag lineOffsetsFlag;
 };
 
-} // namespace metro
\ No newline at end of file
+} // namespace metro
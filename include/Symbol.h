@@ -0,0 +1,111 @@
+#pragma once
+
+#include <string_view>
+#include <cstdint>
+
+namespace metro {
+
+//
+// SymbolID
+//   an interned name of keyword, punctuater or identifier.
+//   the same name always has the same id in the process.
+//
+using SymbolID = uint32_t;
+
+namespace Sym {
+
+//
+// predefined symbols.
+// keep the order same as the names table in Symbol.cpp.
+//
+enum : SymbolID {
+  None,
+
+  /* keywords */
+  Import,
+  Enum,
+  Struct,
+  Def,
+  True,
+  False,
+  New,
+  If,
+  Else,
+  Switch,
+  Case,
+  Default,
+  Loop,
+  While,
+  Do,
+  For,
+  In,
+  Return,
+  Break,
+  Continue,
+
+  /* punctuaters */
+  ShiftLeftAssign,      // <<=
+  ShiftRightAssign,     // >>=
+  Arrow,                // ->
+  ShiftLeft,            // <<
+  ShiftRight,           // >>
+  LessOrEqual,          // <=
+  BiggerOrEqual,        // >=
+  Equal,                // ==
+  NotEqual,             // !=
+  DoubleDot,            // ..
+  LogAND,               // &&
+  LogOR,                // ||
+  Less,                 // <
+  Bigger,               // >
+  Plus,                 // +
+  Minus,                // -
+  Slash,                // /
+  Star,                 // *
+  Percent,              // %
+  Assign,               // =
+  Semicolon,            // ;
+  Colon,                // :
+  Comma,                // ,
+  Dot,                  // .
+  BracketOpen,          // [
+  BracketClose,         // ]
+  ParenOpen,            // (
+  ParenClose,           // )
+  BraceOpen,            // {
+  BraceClose,           // }
+  Exclamation,          // !
+  Question,             // ?
+  Ampersand,            // &
+  Caret,                // ^
+  VerticalBar,          // |
+
+  /* identifiers used by the evaluator */
+  Abs,                  // abs
+  Count,                // count
+
+  /* the first id of other identifiers */
+  _Identifiers,
+
+  _KeywordBegin = Import,
+  _KeywordEnd = ShiftLeftAssign,
+};
+
+} // namespace Sym
+
+class SymbolTable {
+public:
+  //
+  // get the id of "name".
+  // a new id is assigned if not interned yet.
+  //
+  static SymbolID get(std::string_view name);
+
+  static std::string_view getName(SymbolID id);
+
+  static bool isKeyword(SymbolID id) {
+    return id >= Sym::_KeywordBegin && id < Sym::_KeywordEnd;
+  }
+};
+
+} // namespace metro
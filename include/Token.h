@@ -1,10 +1,13 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <cstdint>
+#include "Symbol.h"
 
 namespace metro {
 
-enum class TokenKind {
+enum class TokenKind : uint8_t {
   Unknown,
 
   /* numeric types */
@@ -22,26 +25,47 @@ enum class TokenKind {
   String,
 
   Identifier,
+  Keyword,
 
   Punctuater,
 
   End
 };
 
+namespace objects {
+  struct Object;
+}
+
 struct SourceLoc;
 struct Token {
   TokenKind kind;
-  Token* prev;
-  Token* next;
+  uint32_t position;
+  SymbolID sym;         // Sym::None if not a keyword, punctuater or identifier
+  uint32_t constIndex;  // index in the constant pool if literal
   std::string_view str;
-  size_t position;
   SourceLoc const* source;
 
   size_t getEndPos() const;
 
-  Token(TokenKind kind = TokenKind::Unknown);
-  Token(TokenKind kind, Token* prev, std::string_view str, size_t pos);
-  ~Token();
+  bool isLiteral() const {
+    return this->kind >= TokenKind::Hexadecimal && this->kind <= TokenKind::String;
+  }
+
+  Token(TokenKind kind, std::string_view str, size_t pos, SourceLoc const* source);
 };
 
+//
+// TokenList
+//  all tokens of a script in order. the last one is TokenKind::End.
+//  never append after lexing, AST refers each token with pointer.
+//
+using TokenList = std::vector<Token>;
+
+//
+// ConstantPool
+//  the values of literals in a script, decoded by the lexer.
+//  shared by AST::Value, never deleted by GC.
+//
+using ConstantPool = std::vector<objects::Object*>;
+
 } // namespace metro
\ No newline at end of file
@@ -26,6 +26,11 @@ struct TypeInfo {
     Range,
     Struct,
     Enumerator,
+    Bytes,
+    StringBuilder,
+    Regex,
+    File,
+    Lines,
     Args,
     Any,    // temporary type for templated statements
   };
@@ -35,11 +40,7 @@ struct TypeInfo {
   std::vector<TypeInfo> params;
 
   union {
-    struct {
-      AST::Enum* ast;
-      size_t index;
-    } enum_context;
-
+    AST::Enum const* ast_enum;
     AST::Struct const* ast_struct;
   };
 
@@ -52,6 +53,8 @@ struct TypeInfo {
       case Kind::Vector:
       case Kind::Dict:
       case Kind::Range:
+      case Kind::Bytes:
+      case Kind::Lines:
         return true;
     }
 
@@ -61,7 +64,7 @@ struct TypeInfo {
   TypeInfo(Kind kind = None)
     : kind(kind),
       is_mutable(false),
-      enum_context({nullptr, 0})
+      ast_enum(nullptr)
   {
   }
 
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <thread>
+#include <algorithm>
+#include <atomic>
+#include <vector>
 #include <cstring>
+#include <cstdint>
 #include <string>
 
 namespace metro::utils {
@@ -13,6 +17,180 @@ std::string format(char const* fmt, Ts&&... args) {
   return buf;
 }
 
-std::string open_text_file(std::string const& path);
+//
+// MappedFile
+//   read-only memory mapping of a whole file.
+//
+class MappedFile {
+public:
+  MappedFile(std::string const& path);
+  ~MappedFile();
 
-} // namespace metro::utils
\ No newline at end of file
+  MappedFile(MappedFile const&) = delete;
+
+  bool isOpen() const {
+    return this->opened;
+  }
+
+  std::string_view view() const {
+    return { (char const*)this->data, this->size };
+  }
+
+private:
+  bool opened;
+  void* data;
+  size_t size;
+};
+
+//
+// LineReader
+//   reads lines from a file descriptor through a large buffer.
+//   memory usage is bounded by the buffer (or the longest line).
+//
+class LineReader {
+public:
+  static constexpr size_t BufferSize = 1 << 20;
+
+  LineReader(int fd);
+
+  //
+  // the next line without the line break ("\n" or "\r\n").
+  // "line" refers the buffer, and is valid until the next call.
+  // returns false at the end of file.
+  //
+  bool next(std::string_view& line);
+
+private:
+  bool fill();
+
+  int fd;
+  std::vector<char> buffer;
+  size_t begin;   // the beginning of unread data
+  size_t end;     // the end of data in buffer
+  bool eof;
+};
+
+//
+// UTF-8 --> UTF-16.
+// invalid sequences are replaced with U+FFFD.
+//
+std::u16string decode_utf8(std::string_view str);
+
+//
+// the position of "needle" in "str" at "begin" or after.
+// returns std::u16string_view::npos if not found.
+// candidates are filtered by the first and the last character of needle,
+// 16 characters at once with AVX2 if the cpu supports it.
+//
+size_t find_substr(std::u16string_view str, std::u16string_view needle, size_t begin = 0);
+
+//
+// Random
+//   xoshiro256** pseudo random number generator.
+//   not thread-safe, use get() to take the generator of each thread.
+//
+class Random {
+public:
+  Random(uint64_t seed);
+
+  void seed(uint64_t seed);
+
+  uint64_t next();
+
+  // [0, bound) without bias. (bound > 0)
+  uint64_t nextBelow(uint64_t bound);
+
+  // [0, 1)
+  double nextDouble();
+
+  //
+  // the generator of the current thread.
+  // seeded by std::random_device at first.
+  //
+  static Random& get();
+
+private:
+  uint64_t state[4];
+};
+
+//
+// sort "count" keys by LSD radix sort.
+// "values" are moved together with the keys (stable).
+// passes of bytes which are same in all keys are skipped.
+//
+void radix_sort(uint64_t* keys, size_t* values, size_t count);
+
+//
+// FNV-1a hash.
+//
+uint64_t hash(std::string_view data);
+
+//
+// call "fn(i)" for each i in [0, count) on worker threads.
+// returns after all calls finished.
+//
+template <class F>
+void parallel_for(size_t count, F&& fn) {
+  size_t workers = std::min<size_t>(count, std::thread::hardware_concurrency());
+
+  if( workers <= 1 ) {
+    for( size_t i = 0; i < count; i++ )
+      fn(i);
+
+    return;
+  }
+
+  std::atomic_size_t index = 0;
+  std::vector<std::thread> threads;
+
+  auto work = [&] {
+    for( size_t i; (i = index++) < count; )
+      fn(i);
+  };
+
+  for( size_t i = 1; i < workers; i++ )
+    threads.emplace_back(work);
+
+  work();
+
+  for( auto&& th : threads )
+    th.join();
+}
+
+//
+// sort [first, last) on worker threads.
+// each chunk is sorted in parallel, and merged in pairs until one.
+// same as std::stable_sort if "stable" is true.
+//
+template <class It, class Comp>
+void parallel_sort(It first, It last, Comp comp, bool stable) {
+  // smaller chunks are not worth the threads
+  constexpr size_t MinChunkSize = 1 << 15;
+
+  size_t count = last - first;
+  size_t chunks = 1;
+
+  while( chunks * 2 <= std::thread::hardware_concurrency() && count / (chunks * 2) >= MinChunkSize )
+    chunks *= 2;
+
+  auto bound = [&] (size_t i) {
+    return first + count * i / chunks;
+  };
+
+  parallel_for(chunks, [&] (size_t i) {
+    if( stable )
+      std::stable_sort(bound(i), bound(i + 1), comp);
+    else
+      std::sort(bound(i), bound(i + 1), comp);
+  });
+
+  for( size_t width = 1; width < chunks; width *= 2 ) {
+    parallel_for(chunks / (width * 2), [&] (size_t i) {
+      auto begin = i * width * 2;
+
+      std::inplace_merge(bound(begin), bound(begin + width), bound(begin + width * 2), comp);
+    });
+  }
+}
+
+} // namespace metro::utils
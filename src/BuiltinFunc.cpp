@@ -1,12 +1,20 @@
-#include <iostream>
-#include <sstream>
 #include <vector>
+#include <map>
 #include <cstdlib>
+#include <cmath>
+#include <numeric>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "AST.h"
 #include "GC.h"
 #include "BuiltinFunc.h"
 #include "Error.h"
+#include "Output.h"
+#include "Metro.h"
+#include "Evaluator.h"
+#include "JSON.h"
 
 #define DEF(Name)       static Object* Name(AST::CallFunc* ast, std::vector<Object*>& args)
 #define PASS(Name)      Name(ast, args)
@@ -39,22 +47,87 @@ static bool isMatch(std::vector<Object*> const& args, Ts&&... ts) {
   return _isMatch(args, { std::forward<Ts>(ts)... });
 }
 
+static bool isInteger(Object* obj) {
+  return obj->type.kind == TypeInfo::Int || obj->type.kind == TypeInfo::USize;
+}
+
+static int64_t getInteger(Object* obj) {
+  if( obj->type.kind == TypeInfo::USize )
+    return (int64_t)obj->as<USize>()->value;
+
+  return obj->as<Int>()->value;
+}
+
+//
+// the text of string or char.
+// returns false if "obj" is neither.
+//
+static bool getText(Object* obj, std::u16string_view& text) {
+  switch( obj->type.kind ) {
+    case TypeInfo::String:
+      text = obj->as<String>()->value;
+      return true;
+
+    case TypeInfo::Char:
+      text = std::u16string_view(&obj->as<Char>()->value, 1);
+      return true;
+  }
+
+  return false;
+}
+
+static bool isSpace(char16_t c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+//
+// vector of strings of "pieces".
+// the strings are appended to the vector bound to GC, since GC may run
+// while creating them.
+//
+static Vector* makeStrings(std::vector<std::u16string_view> const& pieces) {
+  auto vec = new Vector;
+
+  GC::bind(vec);
+  vec->elements.reserve(pieces.size());
+
+  for( auto&& piece : pieces )
+    vec->append(new String(std::u16string(piece)));
+
+  GC::unbind(vec);
+
+  return vec;
+}
+
+//
+// check that [offset, offset + size) is in bytes.
+//
+static void checkRange(AST::CallFunc* ast, Bytes* bytes, int64_t offset, int64_t size) {
+  if( offset < 0 || size < 0 || (uint64_t)offset > bytes->get().size()
+    || (uint64_t)size > bytes->get().size() - offset ) {
+    Error(ast->token)
+      .setMessage(
+        "range out of bytes (the range is " + std::to_string(offset) + " .. "
+          + std::to_string(offset + size) + " but the size is "
+          + std::to_string(bytes->get().size()) + ")")
+      .emit()
+      .exit();
+  }
+}
+
 //
 // print
 //
 DEF( print ) {
   (void)ast;
 
-  std::stringstream ss;
+  auto& out = Output::getStdout();
+  auto begin = out.getCount();
 
   for( auto&& arg : args )
-    ss << arg->to_string();
-
-  auto s = ss.str();
+    out.write(arg);
 
-  std::cout << s;
-
-  return new Int(s.length());
+  return new Int(out.getCount() - begin);
 }
 
 //
@@ -63,37 +136,156 @@ DEF( print ) {
 DEF( println ) {
   (void)ast;
 
-  args.emplace_back(new Char('\n'));
-  return PASS(print);
+  auto& out = Output::getStdout();
+  auto begin = out.getCount();
+
+  for( auto&& arg : args )
+    out.write(arg);
+
+  out.put('\n');
+
+  return new Int(out.getCount() - begin);
+}
+
+//
+// flush
+//
+DEF( flush ) {
+  if( !args.empty() )
+    ILLEGAL;
+
+  Output::getStdout().flush();
+
+  return None::getNone();
+}
+
+//
+// random integer in [begin, end)
+//
+static int64_t randomInt(AST::CallFunc* ast, int64_t begin, int64_t end) {
+  if( begin >= end ) {
+    Error(ast->token)
+      .setMessage("start value must less than end")
+      .emit()
+      .exit();
+  }
+
+  return begin + (int64_t)utils::Random::get().nextBelow((uint64_t)end - (uint64_t)begin);
 }
 
 //
 // random
+//   random(range)
+//   random(begin, end)
 //
 DEF( random ) {
   // range
   if( MATCH(TypeInfo::Range) ) {
     auto range = args[0]->as<Range>();
-    return new Int(rand() % (range->end - range->begin));
+    return new Int(randomInt(ast, range->begin, range->end));
   }
   // begin, end
   else if( MATCH(TypeInfo::Int, TypeInfo::Int) ) {
-    auto begin = args[0]->as<Int>()->value;
-    auto end = args[1]->as<Int>()->value;
+    return new Int(randomInt(ast, args[0]->as<Int>()->value, args[1]->as<Int>()->value));
+  }
 
-    if( begin >= end ) {
-      Error(ast->token)
-        .setMessage("start value must less than end")
-        .emit()
-        .exit();
-    }
+  ILLEGAL;
+}
+
+//
+// random_float
+//   random_float()           --> [0, 1)
+//   random_float(min, max)   --> [min, max)
+//
+DEF( random_float ) {
+  auto value = utils::Random::get().nextDouble();
+
+  if( args.empty() )
+    return new Float(value);
 
-    return new Int(rand() % (end - begin));
+  if( MATCH(TypeInfo::Float, TypeInfo::Float) ) {
+    auto min = args[0]->as<Float>()->value;
+    auto max = args[1]->as<Float>()->value;
+
+    return new Float(min + (max - min) * value);
   }
 
   ILLEGAL;
 }
 
+//
+// seed
+//   seed the generator of random, random_float and random_vector.
+//   same seed gives same sequence.
+//
+DEF( seed ) {
+  if( args.size() != 1 || !isInteger(args[0]) )
+    ILLEGAL;
+
+  utils::Random::get().seed((uint64_t)getInteger(args[0]));
+
+  return None::getNone();
+}
+
+//
+// random_vector
+//   random_vector(count, range)  --> vector of int in range
+//   random_vector(count)         --> vector of float in [0, 1)
+//
+DEF( random_vector ) {
+  if( args.empty() || !isInteger(args[0]) || getInteger(args[0]) < 0 )
+    ILLEGAL;
+
+  auto count = (size_t)getInteger(args[0]);
+  auto& random = utils::Random::get();
+
+  // the vector and all of the elements are alive
+  if( count >= GC::maxObjectCount() ) {
+    Error(ast->arguments[0])
+      .setMessage("too large count (the count is " + std::to_string(count)
+        + ", must be less than " + std::to_string(GC::maxObjectCount()) + ")")
+      .emit()
+      .exit();
+  }
+
+  if( args.size() == 2 ) {
+    if( args[1]->type.kind != TypeInfo::Range )
+      ILLEGAL;
+
+    // check the range
+    if( count )
+      randomInt(ast, args[1]->as<Range>()->begin, args[1]->as<Range>()->end);
+  }
+  else if( args.size() != 1 )
+    ILLEGAL;
+
+  //
+  // the elements are appended to the vector bound to GC,
+  // since GC may run while creating them.
+  // reserved, so that the elements are not moved while being marked.
+  //
+  auto vec = new Vector;
+
+  GC::bind(vec);
+  vec->elements.reserve(count);
+
+  if( args.size() == 1 ) {
+    for( size_t i = 0; i < count; i++ )
+      vec->append(new Float(random.nextDouble()));
+  }
+  else {
+    auto range = args[1]->as<Range>();
+    auto width = (uint64_t)range->end - (uint64_t)range->begin;
+
+    for( size_t i = 0; i < count; i++ )
+      vec->append(new Int(range->begin + (int64_t)random.nextBelow(width)));
+  }
+
+  GC::unbind(vec);
+
+  return vec;
+}
+
 //
 // vector
 //
@@ -123,11 +315,939 @@ DEF( vector ) {
   ILLEGAL;
 }
 
+//
+// open
+//   open(path)        --> read
+//   open(path, mode)  --> mode = "r", "w" or "a"
+//
+DEF( open ) {
+  auto mode = File::Mode::Read;
+
+  if( MATCH(TypeInfo::String, TypeInfo::String) ) {
+    auto m = args[1]->to_string();
+
+    if( m == "w" )
+      mode = File::Mode::Write;
+    else if( m == "a" )
+      mode = File::Mode::Append;
+    else if( m != "r" ) {
+      Error(ast->arguments[1])
+        .setMessage("invalid mode '" + m + "'")
+        .emit()
+        .exit();
+    }
+  }
+  else if( !MATCH(TypeInfo::String) )
+    ILLEGAL;
+
+  auto file = new File(args[0]->to_string(), mode);
+
+  if( !file->open() ) {
+    Error(ast->arguments[0])
+      .setMessage("cannot open file '" + file->path + "'")
+      .emit()
+      .exit();
+  }
+
+  return file;
+}
+
+//
+// close
+//
+DEF( close ) {
+  if( !MATCH(TypeInfo::File) )
+    ILLEGAL;
+
+  args[0]->as<File>()->close();
+
+  return None::getNone();
+}
+
+//
+// read_lines
+//   read_lines(path or file)
+//   lines are read while iterating by "for".
+//
+DEF( read_lines ) {
+  if( MATCH(TypeInfo::String) )
+    return new Lines(args[0]->to_string());
+
+  if( MATCH(TypeInfo::File) )
+    return new Lines(args[0]->as<File>());
+
+  ILLEGAL;
+}
+
+//
+// read_bytes
+//   the contents of a file as bytes.
+//
+DEF( read_bytes ) {
+  if( !MATCH(TypeInfo::String) )
+    ILLEGAL;
+
+  auto path = args[0]->to_string();
+  utils::MappedFile file{ path };
+
+  if( !file.isOpen() ) {
+    Error(ast->arguments[0])
+      .setMessage("cannot open file '" + path + "'")
+      .emit()
+      .exit();
+  }
+
+  auto view = file.view();
+
+  return new Bytes(std::vector<uint8_t>(view.begin(), view.end()));
+}
+
+//
+// write the text of args[1...] to a file (path or opened file).
+// returns the bytes written.
+//
+static Object* writeFile(AST::CallFunc* ast, std::vector<Object*>& args, File::Mode mode) {
+  if( args.empty() )
+    ILLEGAL;
+
+  auto writeArgs = [&] (Output& out) {
+    auto begin = out.getCount();
+
+    for( auto it = args.begin() + 1; it != args.end(); it++ ) {
+      // bytes are written as is
+      if( (*it)->type.kind == TypeInfo::Bytes ) {
+        auto& bytes = (*it)->as<Bytes>()->get();
+
+        out.write(std::string_view((char const*)bytes.data(), bytes.size()));
+      }
+      else
+        out.write(*it);
+    }
+
+    return new Int(out.getCount() - begin);
+  };
+
+  // opened file
+  if( args[0]->type.kind == TypeInfo::File ) {
+    auto file = args[0]->as<File>();
+
+    if( !file->isWritable() ) {
+      Error(ast->arguments[0])
+        .setMessage("file '" + file->path + "' is not opened for writing")
+        .emit()
+        .exit();
+    }
+
+    return writeArgs(*file->out);
+  }
+
+  if( args[0]->type.kind != TypeInfo::String )
+    ILLEGAL;
+
+  auto path = args[0]->to_string();
+  auto fd = ::open(path.c_str(),
+    O_WRONLY | O_CREAT | O_CLOEXEC | (mode == File::Mode::Append ? O_APPEND : O_TRUNC), 0644);
+
+  if( fd < 0 ) {
+    Error(ast->arguments[0])
+      .setMessage("cannot open file '" + path + "'")
+      .emit()
+      .exit();
+  }
+
+  Object* ret;
+
+  {
+    Output out{ fd, Output::Mode::Full };
+
+    ret = writeArgs(out);
+  }
+
+  ::close(fd);
+
+  return ret;
+}
+
+//
+// write
+//   write(path or file, values...)
+//   the file is truncated if path is given.
+//
+DEF( write ) {
+  return writeFile(ast, args, File::Mode::Write);
+}
+
+//
+// append
+//   append(path or file, values...)
+//
+DEF( append ) {
+  return writeFile(ast, args, File::Mode::Append);
+}
+
+//
+// bytes
+//   bytes(count)   --> zero-filled
+//   bytes(string)  --> UTF-8
+//   bytes(vector)  --> vector of int
+//
+DEF( bytes ) {
+  if( args.size() != 1 )
+    ILLEGAL;
+
+  auto arg = args[0];
+
+  if( isInteger(arg) && getInteger(arg) >= 0 ) {
+    std::vector<uint8_t> buf;
+
+    try {
+      buf.resize(getInteger(arg));
+    }
+    catch( std::bad_alloc const& ) {
+      Error(ast->arguments[0])
+        .setMessage("cannot allocate " + std::to_string(getInteger(arg)) + " bytes")
+        .emit()
+        .exit();
+    }
+
+    return new Bytes(std::move(buf));
+  }
+
+  if( MATCH(TypeInfo::String) ) {
+    auto str = arg->to_string();
+
+    return new Bytes(std::vector<uint8_t>(str.begin(), str.end()));
+  }
+
+  if( MATCH(TypeInfo::Vector) ) {
+    std::vector<uint8_t> buf;
+
+    buf.reserve(arg->as<Vector>()->elements.size());
+
+    for( auto&& e : arg->as<Vector>()->elements ) {
+      if( e->type.kind != TypeInfo::Int )
+        ILLEGAL;
+
+      if( e->as<Int>()->value < 0 || e->as<Int>()->value > 255 ) {
+        Error(ast->arguments[0])
+          .setMessage("byte value out of range (the value is "
+            + std::to_string(e->as<Int>()->value) + ")")
+          .emit()
+          .exit();
+      }
+
+      buf.emplace_back((uint8_t)e->as<Int>()->value);
+    }
+
+    return new Bytes(std::move(buf));
+  }
+
+  ILLEGAL;
+}
+
+//
+// decode
+//   UTF-8 bytes --> string
+//
+DEF( decode ) {
+  if( !MATCH(TypeInfo::Bytes) )
+    ILLEGAL;
+
+  auto& bytes = args[0]->as<Bytes>()->get();
+
+  return new String(std::string_view((char const*)bytes.data(), bytes.size()));
+}
+
+//
+// slice
+//   slice(bytes, begin, end)
+//
+DEF( slice ) {
+  if( args.size() != 3 || args[0]->type.kind != TypeInfo::Bytes
+    || !isInteger(args[1]) || !isInteger(args[2]) )
+    ILLEGAL;
+
+  auto bytes = args[0]->as<Bytes>();
+  auto begin = getInteger(args[1]);
+  auto end = getInteger(args[2]);
+
+  checkRange(ast, bytes, begin, end - begin);
+
+  return new Bytes(std::vector<uint8_t>(bytes->get().begin() + begin, bytes->get().begin() + end));
+}
+
+//
+// read an integer from bytes.
+//   read_le(bytes, offset, size)
+//   read_be(bytes, offset, size)
+//
+static Object* readInt(AST::CallFunc* ast, std::vector<Object*>& args, bool bigEndian) {
+  if( args.size() != 3 || args[0]->type.kind != TypeInfo::Bytes
+    || !isInteger(args[1]) || !isInteger(args[2]) )
+    ILLEGAL;
+
+  auto bytes = args[0]->as<Bytes>();
+  auto offset = getInteger(args[1]);
+  auto size = getInteger(args[2]);
+
+  if( size < 1 || size > 8 ) {
+    Error(ast->arguments[2])
+      .setMessage("size must be 1 to 8")
+      .emit()
+      .exit();
+  }
+
+  checkRange(ast, bytes, offset, size);
+
+  return new Int((int64_t)bytes->readInt(offset, size, bigEndian));
+}
+
+DEF( read_le ) {
+  return readInt(ast, args, false);
+}
+
+DEF( read_be ) {
+  return readInt(ast, args, true);
+}
+
+//
+// write an integer to bytes.
+//   write_le(bytes, offset, size, value)
+//   write_be(bytes, offset, size, value)
+//   returns the bytes written. (b = write_le(b, ...))
+//
+static Object* writeInt(AST::CallFunc* ast, std::vector<Object*>& args, bool bigEndian) {
+  if( args.size() != 4 || args[0]->type.kind != TypeInfo::Bytes
+    || !isInteger(args[1]) || !isInteger(args[2]) || !isInteger(args[3]) )
+    ILLEGAL;
+
+  auto bytes = args[0]->as<Bytes>();
+  auto offset = getInteger(args[1]);
+  auto size = getInteger(args[2]);
+
+  if( size < 1 || size > 8 ) {
+    Error(ast->arguments[2])
+      .setMessage("size must be 1 to 8")
+      .emit()
+      .exit();
+  }
+
+  checkRange(ast, bytes, offset, size);
+
+  bytes->writeInt(offset, size, bigEndian, (uint64_t)getInteger(args[3]));
+
+  return bytes;
+}
+
+DEF( write_le ) {
+  return writeInt(ast, args, false);
+}
+
+DEF( write_be ) {
+  return writeInt(ast, args, true);
+}
+
+//
+// find
+//   find(bytes, needle)
+//   find(bytes, needle, begin)
+//   find(string, needle)         --> needle is string or char
+//   find(string, needle, begin)
+//   returns the index, or -1 if not found.
+//
+DEF( find ) {
+  std::u16string_view needle;
+
+  if( args.size() < 2 || args.size() > 3 )
+    ILLEGAL;
+
+  if( args.size() == 3 && (!isInteger(args[2]) || getInteger(args[2]) < 0) )
+    ILLEGAL;
+
+  size_t begin = args.size() == 3 ? getInteger(args[2]) : 0;
+
+  if( args[0]->type.kind == TypeInfo::Bytes && args[1]->type.kind == TypeInfo::Bytes )
+    return new Int(args[0]->as<Bytes>()->find(args[1]->as<Bytes>(), begin));
+
+  if( args[0]->type.kind == TypeInfo::String && getText(args[1], needle) ) {
+    auto pos = utils::find_substr(args[0]->as<String>()->value, needle, begin);
+
+    return new Int(pos == needle.npos ? -1 : (int64_t)pos);
+  }
+
+  ILLEGAL;
+}
+
+//
+// compare
+//   compare(bytes, bytes) --> -1, 0 or 1
+//
+DEF( compare ) {
+  if( !MATCH(TypeInfo::Bytes, TypeInfo::Bytes) )
+    ILLEGAL;
+
+  return new Int(args[0]->as<Bytes>()->compare(args[1]->as<Bytes>()));
+}
+
+//
+// string_builder
+//   string_builder()     --> empty
+//   string_builder(str)  --> starts with str
+//   append with "sb + x", and get the string by build(sb).
+//
+DEF( string_builder ) {
+  if( args.empty() )
+    return new StringBuilder;
+
+  if( MATCH(TypeInfo::String) )
+    return new StringBuilder(args[0]->as<String>()->value);
+
+  ILLEGAL;
+}
+
+//
+// build
+//   build(sb) --> the string built by sb
+//
+DEF( build ) {
+  if( !MATCH(TypeInfo::StringBuilder) )
+    ILLEGAL;
+
+  return new String(args[0]->as<StringBuilder>()->value);
+}
+
+//
+// split
+//   split(str)       --> split by runs of white spaces
+//   split(str, sep)  --> split by sep (string or char)
+//
+DEF( split ) {
+  std::u16string_view sep;
+
+  if( args.empty() || args[0]->type.kind != TypeInfo::String )
+    ILLEGAL;
+
+  std::u16string_view str = args[0]->as<String>()->value;
+  std::vector<std::u16string_view> pieces;
+
+  if( args.size() == 1 ) {
+    for( size_t i = 0; i < str.length(); ) {
+      while( i < str.length() && isSpace(str[i]) )
+        i++;
+
+      auto begin = i;
+
+      while( i < str.length() && !isSpace(str[i]) )
+        i++;
+
+      if( begin < i )
+        pieces.emplace_back(str.substr(begin, i - begin));
+    }
+  }
+  else if( args.size() == 2 && getText(args[1], sep) ) {
+    if( sep.empty() ) {
+      Error(ast->arguments[1])
+        .setMessage("separator is empty")
+        .emit()
+        .exit();
+    }
+
+    for( size_t begin = 0;; ) {
+      auto pos = utils::find_substr(str, sep, begin);
+
+      pieces.emplace_back(str.substr(begin, pos - begin));
+
+      if( pos == str.npos )
+        break;
+
+      begin = pos + sep.length();
+    }
+  }
+  else
+    ILLEGAL;
+
+  return makeStrings(pieces);
+}
+
+//
+// lines
+//   lines(str) --> split by "\n" or "\r\n".
+//   no empty line is made after the last newline.
+//
+DEF( lines ) {
+  if( !MATCH(TypeInfo::String) )
+    ILLEGAL;
+
+  std::u16string_view str = args[0]->as<String>()->value;
+  std::vector<std::u16string_view> pieces;
+
+  for( size_t begin = 0; begin < str.length(); ) {
+    auto end = std::min(str.find(u'\n', begin), str.length());
+    auto next = end + 1;
+
+    if( end > begin && str[end - 1] == '\r' )
+      end--;
+
+    pieces.emplace_back(str.substr(begin, end - begin));
+
+    begin = next;
+  }
+
+  return makeStrings(pieces);
+}
+
+//
+// replace
+//   replace(str, from, to) --> replace all of "from" in str with "to".
+//   from and to are string or char.
+//   from can be a regex, then all matches of it are replaced.
+//
+DEF( replace ) {
+  std::u16string_view from, to;
+
+  if( args.size() != 3 || args[0]->type.kind != TypeInfo::String || !getText(args[2], to) )
+    ILLEGAL;
+
+  if( args[1]->type.kind == TypeInfo::Regex ) {
+    std::u16string_view str = args[0]->as<String>()->value;
+    std::u16string ret;
+    size_t last = 0;
+
+    for( auto&& [begin, end] : args[1]->as<Regex>()->compiled->findAll(str) ) {
+      ret.append(str.substr(last, begin - last)).append(to);
+      last = end;
+    }
+
+    ret.append(str.substr(last));
+
+    return new String(std::move(ret));
+  }
+
+  if( !getText(args[1], from) )
+    ILLEGAL;
+
+  if( from.empty() ) {
+    Error(ast->arguments[1])
+      .setMessage("string to replace is empty")
+      .emit()
+      .exit();
+  }
+
+  std::u16string_view str = args[0]->as<String>()->value;
+  std::u16string ret;
+
+  ret.reserve(str.length());
+
+  for( size_t begin = 0;; ) {
+    auto pos = utils::find_substr(str, from, begin);
+
+    ret.append(str.substr(begin, pos - begin));
+
+    if( pos == str.npos )
+      break;
+
+    ret.append(to);
+    begin = pos + from.length();
+  }
+
+  return new String(std::move(ret));
+}
+
+//
+// join
+//   join(vector, sep) --> texts of elements joined with sep.
+//
+DEF( join ) {
+  std::u16string_view sep;
+
+  if( args.size() != 2 || args[0]->type.kind != TypeInfo::Vector || !getText(args[1], sep) )
+    ILLEGAL;
+
+  std::u16string ret;
+
+  for( bool first = true; auto&& e : args[0]->as<Vector>()->elements ) {
+    if( !first )
+      ret.append(sep);
+
+    StringBuilder::appendText(ret, e);
+    first = false;
+  }
+
+  return new String(std::move(ret));
+}
+
+//
+// starts_with
+//   starts_with(str, prefix)
+//
+DEF( starts_with ) {
+  std::u16string_view prefix;
+
+  if( args.size() != 2 || args[0]->type.kind != TypeInfo::String || !getText(args[1], prefix) )
+    ILLEGAL;
+
+  return new Bool(std::u16string_view(args[0]->as<String>()->value).starts_with(prefix));
+}
+
+//
+// ends_with
+//   ends_with(str, suffix)
+//
+DEF( ends_with ) {
+  std::u16string_view suffix;
+
+  if( args.size() != 2 || args[0]->type.kind != TypeInfo::String || !getText(args[1], suffix) )
+    ILLEGAL;
+
+  return new Bool(std::u16string_view(args[0]->as<String>()->value).ends_with(suffix));
+}
+
+//
+// trim
+//   trim(str) --> str without white spaces at the both ends.
+//
+DEF( trim ) {
+  if( !MATCH(TypeInfo::String) )
+    ILLEGAL;
+
+  std::u16string_view str = args[0]->as<String>()->value;
+
+  while( !str.empty() && isSpace(str.front()) )
+    str.remove_prefix(1);
+
+  while( !str.empty() && isSpace(str.back()) )
+    str.remove_suffix(1);
+
+  return new String(std::u16string(str));
+}
+
+//
+// regex
+//   regex(pattern) --> compiled regular expression.
+//   see Regex.h for the syntax.
+//
+DEF( regex ) {
+  // compiled patterns, so that regex() in a loop does not compile again
+  thread_local std::map<std::u16string, std::shared_ptr<regex::Pattern>> cache;
+
+  if( !MATCH(TypeInfo::String) )
+    ILLEGAL;
+
+  auto& pattern = args[0]->as<String>()->value;
+
+  if( auto it = cache.find(pattern); it != cache.end() )
+    return new Regex(pattern, it->second);
+
+  std::string error;
+  auto compiled = regex::Pattern::compile(pattern, error);
+
+  if( !compiled ) {
+    Error(ast->arguments[0])
+      .setMessage("invalid regex: " + error)
+      .emit()
+      .exit();
+  }
+
+  if( cache.size() >= 64 )
+    cache.clear();
+
+  cache.emplace(pattern, compiled);
+
+  return new Regex(pattern, std::move(compiled));
+}
+
+//
+// match
+//   match(re, str) --> true if whole of str matches
+//
+DEF( match ) {
+  if( !MATCH(TypeInfo::Regex, TypeInfo::String) )
+    ILLEGAL;
+
+  return new Bool(args[0]->as<Regex>()->compiled->match(args[1]->as<String>()->value));
+}
+
+//
+// search
+//   search(re, str)
+//   search(re, str, begin)
+//   returns the index of the leftmost match at begin or after, or -1.
+//
+DEF( search ) {
+  if( args.size() < 2 || args.size() > 3
+    || args[0]->type.kind != TypeInfo::Regex || args[1]->type.kind != TypeInfo::String )
+    ILLEGAL;
+
+  if( args.size() == 3 && (!isInteger(args[2]) || getInteger(args[2]) < 0) )
+    ILLEGAL;
+
+  auto& str = args[1]->as<String>()->value;
+  size_t begin = args.size() == 3 ? getInteger(args[2]) : 0;
+  size_t matchBegin, matchEnd;
+
+  if( begin > str.length()
+    || !args[0]->as<Regex>()->compiled->search(str, begin, matchBegin, matchEnd) )
+    return new Int(-1);
+
+  return new Int((int64_t)matchBegin);
+}
+
+//
+// find_all
+//   find_all(re, str) --> vector of the matched strings, not overlapped.
+//
+DEF( find_all ) {
+  if( !MATCH(TypeInfo::Regex, TypeInfo::String) )
+    ILLEGAL;
+
+  std::u16string_view str = args[1]->as<String>()->value;
+  std::vector<std::u16string_view> pieces;
+
+  for( auto&& [begin, end] : args[0]->as<Regex>()->compiled->findAll(str) )
+    pieces.emplace_back(str.substr(begin, end - begin));
+
+  return makeStrings(pieces);
+}
+
+//
+// json_parse
+//   json_parse(str)           --> the value of JSON text
+//   json_parse(str, pointer)  --> the value at JSON Pointer (e.g. "/users/0/name"),
+//                                 or none if not found.
+//   see JSON.h for the types of values.
+//
+DEF( json_parse ) {
+  std::string error;
+  Object* ret;
+
+  if( MATCH(TypeInfo::String) )
+    ret = json::parse(args[0]->as<String>()->value, error);
+  else if( MATCH(TypeInfo::String, TypeInfo::String) ) {
+    auto& pointer = args[1]->as<String>()->value;
+
+    if( !pointer.empty() && pointer[0] != '/' ) {
+      Error(ast->arguments[1])
+        .setMessage("json pointer must start with '/'")
+        .emit()
+        .exit();
+    }
+
+    ret = json::parse(args[0]->as<String>()->value, pointer, error);
+  }
+  else
+    ILLEGAL;
+
+  if( !error.empty() ) {
+    Error(ast->arguments[0])
+      .setMessage("invalid json: " + error)
+      .emit()
+      .exit();
+  }
+
+  return ret ? ret : None::getNone();
+}
+
+//
+// json_stringify
+//   json_stringify(obj) --> JSON text of obj, without spaces.
+//
+DEF( json_stringify ) {
+  if( args.size() != 1 )
+    ILLEGAL;
+
+  std::string error;
+  std::u16string ret;
+
+  if( !json::stringify(ret, args[0], error) ) {
+    Error(ast->arguments[0])
+      .setMessage(error)
+      .emit()
+      .exit();
+  }
+
+  return new String(std::move(ret));
+}
+
+// integers at least this count are sorted by radix sort
+static constexpr size_t RadixSortThreshold = 256;
+
+static bool isAllOf(std::vector<Object*> const& elems, TypeInfo::Kind kind) {
+  for( auto&& e : elems )
+    if( e->type.kind != kind )
+      return false;
+
+  return true;
+}
+
+//
+// sort a vector of Int or USize by the values.
+// the elements are reordered by the sorted keys, and never rewritten,
+// since they may be literals or appear more than once.
+//
+template <class T>
+static void sortIntegers(std::vector<Object*>& elems) {
+  // flip the sign bit to sort signed values as unsigned
+  constexpr uint64_t flip = std::is_signed_v<typename T::ValueType> ? 1ull << 63 : 0;
+
+  std::vector<uint64_t> keys(elems.size());
+  std::vector<size_t> indices(elems.size());
+
+  for( size_t i = 0; i < elems.size(); i++ ) {
+    keys[i] = (uint64_t)elems[i]->as<T>()->value ^ flip;
+    indices[i] = i;
+  }
+
+  if( keys.size() >= RadixSortThreshold )
+    utils::radix_sort(keys.data(), indices.data(), keys.size());
+  else {
+    std::sort(indices.begin(), indices.end(), [&keys] (size_t a, size_t b) {
+      return keys[a] < keys[b];
+    });
+  }
+
+  std::vector<Object*> sorted(elems.size());
+
+  for( size_t i = 0; i < elems.size(); i++ )
+    sorted[i] = elems[indices[i]];
+
+  elems = std::move(sorted);
+}
+
+static void sortFloats(std::vector<Object*>& elems, bool stable) {
+  // NaN is last
+  utils::parallel_sort(elems.begin(), elems.end(), [] (Object* a, Object* b) {
+    auto x = a->as<Float>()->value;
+    auto y = b->as<Float>()->value;
+
+    return x < y || (!std::isnan(x) && std::isnan(y));
+  }, stable);
+}
+
+static Object* sortVector(AST::CallFunc* ast, std::vector<Object*>& args, bool stable) {
+  if( !MATCH(TypeInfo::Vector) )
+    ILLEGAL;
+
+  auto& elems = args[0]->as<Vector>()->elements;
+
+  // equal integers are not distinguishable, so stable or not doesn't matter.
+  // (-0.0 and 0.0 are equal floats, but distinguishable)
+  if( isAllOf(elems, TypeInfo::Int) )
+    sortIntegers<Int>(elems);
+  else if( isAllOf(elems, TypeInfo::USize) )
+    sortIntegers<USize>(elems);
+  else if( isAllOf(elems, TypeInfo::Float) )
+    sortFloats(elems, stable);
+  else {
+    utils::parallel_sort(elems.begin(), elems.end(), [] (Object* a, Object* b) {
+      return a->compare(b) < 0;
+    }, stable);
+  }
+
+  return args[0];
+}
+
+//
+// sort
+//   sort(vector) --> sorted vector
+//   the order is same as Object::compare.
+//
+DEF( sort ) {
+  return sortVector(ast, args, false);
+}
+
+//
+// stable_sort
+//   same as sort, but the order of equal elements is kept.
+//
+DEF( stable_sort ) {
+  return sortVector(ast, args, true);
+}
+
+//
+// sort_by
+//   sort_by(vector, "name")
+//   stable sort by the key which the function "name" returns for each element.
+//   the function is called once per element.
+//
+DEF( sort_by ) {
+  if( !MATCH(TypeInfo::Vector, TypeInfo::String) )
+    ILLEGAL;
+
+  auto& elems = args[0]->as<Vector>()->elements;
+  auto name = SymbolTable::get(args[1]->to_string());
+
+  auto keys = new Vector;
+
+  GC::bind(keys);
+
+  for( auto&& e : elems ) {
+    std::vector<Object*> param{ e->clone() };
+
+    keys->append(Metro::getInstance()->getEvaluator()->callFunction(ast, name, param));
+  }
+
+  std::vector<size_t> indices(elems.size());
+
+  std::iota(indices.begin(), indices.end(), 0);
+
+  utils::parallel_sort(indices.begin(), indices.end(), [&] (size_t a, size_t b) {
+    return keys->elements[a]->compare(keys->elements[b]) < 0;
+  }, true);
+
+  std::vector<Object*> sorted(elems.size());
+
+  for( size_t i = 0; i < indices.size(); i++ )
+    sorted[i] = elems[indices[i]];
+
+  elems = std::move(sorted);
+
+  GC::unbind(keys);
+
+  return args[0];
+}
+
 static std::vector<BuiltinFunc> const _all_functions {
   BUILTIN(print),
   BUILTIN(println),
+  BUILTIN(flush),
   BUILTIN(random),
+  BUILTIN(random_float),
+  BUILTIN(seed),
+  BUILTIN(random_vector),
   BUILTIN(vector),
+  BUILTIN(open),
+  BUILTIN(close),
+  BUILTIN(read_lines),
+  BUILTIN(read_bytes),
+  BUILTIN(write),
+  BUILTIN(append),
+  BUILTIN(bytes),
+  BUILTIN(decode),
+  BUILTIN(slice),
+  BUILTIN(read_le),
+  BUILTIN(read_be),
+  BUILTIN(write_le),
+  BUILTIN(write_be),
+  BUILTIN(find),
+  BUILTIN(compare),
+  BUILTIN(string_builder),
+  BUILTIN(build),
+  BUILTIN(split),
+  BUILTIN(lines),
+  BUILTIN(replace),
+  BUILTIN(join),
+  BUILTIN(starts_with),
+  BUILTIN(ends_with),
+  BUILTIN(trim),
+  BUILTIN(regex),
+  BUILTIN(match),
+  BUILTIN(search),
+  BUILTIN(find_all),
+  BUILTIN(json_parse),
+  BUILTIN(json_stringify),
+  BUILTIN(sort),
+  BUILTIN(stable_sort),
+  BUILTIN(sort_by),
 
 };
 
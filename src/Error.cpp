@@ -1,12 +1,20 @@
 #include <iostream>
+#include <mutex>
 #include "alert.h"
 #include "Metro.h"
 #include "Error.h"
+#include "Output.h"
 
 namespace metro {
 
 std::vector<Error> Metro::emittedErrors;
 
+// errors may be emitted from the threads loading modules
+static std::mutex emitMutex;
+
+// in the scope of Error::Defer
+static thread_local bool deferExit;
+
 Error::Error(ErrorLocation location)
   : location(location)
 {
@@ -19,6 +27,11 @@ Error& Error::setMessage(std::string const& msg) {
 }
 
 Error& Error::emit() {
+  std::lock_guard lock{ emitMutex };
+
+  // keep the order with the output of the script
+  Output::getStdout().flush();
+
   size_t beginPos = 0;
   size_t endPos   = 0;
   SourceLoc const* source = nullptr;
@@ -45,22 +58,11 @@ Error& Error::emit() {
     }
   }
 
-  size_t trimBegin  = 0;
-  size_t trimEnd    = source->data.length();
-
-  size_t linenum = 1;
-
-  for( size_t i = 0; i < beginPos; i++ ) {
-    if( source->data[i] == '\n' ) {
-      linenum++;
-      trimBegin = i + 1;
-    }
-  }
+  auto lineIndex = source->getLineIndex(beginPos);
 
-  for( trimEnd = endPos; trimEnd < source->data.length(); trimEnd++ ) {
-    if( source->data[trimEnd] == '\n' )
-      break;
-  }
+  size_t linenum    = lineIndex + 1;
+  size_t trimBegin  = source->getLineBegin(lineIndex);
+  size_t trimEnd    = source->getLineEnd(source->getLineIndex(endPos));
 
   auto errline =
     source->data.substr(trimBegin, trimEnd - trimBegin);
@@ -79,6 +81,9 @@ Error& Error::emit() {
 }
 
 void Error::exit() {
+  if( deferExit )
+    throw Aborted{ };
+
   std::exit(1);
 }
 
@@ -87,4 +92,14 @@ void Error::check() {
     std::exit(1);
 }
 
+Error::Defer::Defer()
+  : saved(deferExit)
+{
+  deferExit = true;
+}
+
+Error::Defer::~Defer() {
+  deferExit = this->saved;
+}
+
 } // namespace metro
\ No newline at end of file
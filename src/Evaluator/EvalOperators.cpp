@@ -1,5 +1,6 @@
 #include <iostream>
 #include <sstream>
+#include <optional>
 #include "alert.h"
 #include "BuiltinFunc.h"
 #include "Evaluator.h"
@@ -16,6 +17,16 @@ using namespace objects;
 
 namespace {
 
+[[noreturn]]
+void invalidOperator(AST::Expr* expr, Object* lhs, Object* rhs) {
+  Error(expr->token)
+    .setMessage(
+      "invalid operator: '" + lhs->type.to_string() + "' "
+        + std::string(expr->token->str) + " '" + rhs->type.to_string() + "'")
+    .emit()
+    .exit();
+}
+
 /*
  * obj_add
  */
@@ -77,11 +88,35 @@ Object* obj_add(AST::Expr* expr, Object* lhs, Object* rhs) {
       }
       break;
 
+    // bytes + bytes
+    case TypeInfo::Bytes:
+      if( rhs->type.kind == TypeInfo::Bytes ) {
+        auto ret = lhs->as<Bytes>()->clone();
+
+        auto& src = rhs->as<Bytes>()->get();
+
+        ret->getMutable().insert(ret->getMutable().end(), src.begin(), src.end());
+
+        return ret;
+      }
+
+      break;
+
+    // string_builder + any --> append in place
+    case TypeInfo::StringBuilder:
+      return lhs->as<StringBuilder>()->append(rhs);
+
     case TypeInfo::Char:
       switch( rhs->type.kind ) {
+        // char + string
         case TypeInfo::String: {
-          rhs->as<String>()->value.insert(rhs->as<String>()->value.begin(), lhs->as<Char>()->clone());
-          return rhs;
+          auto ret = new String;
+
+          ret->value.reserve(rhs->as<String>()->value.length() + 1);
+          ret->value.push_back(lhs->as<Char>()->value);
+          ret->value.append(rhs->as<String>()->value);
+
+          return ret;
         }
       }
 
@@ -202,9 +237,10 @@ Object* obj_mul(AST::Expr* expr, Object* lhs, Object* rhs) {
         case TypeInfo::String: {
           auto obj = new String();
 
+          obj->value.reserve(rhs->as<String>()->value.length() * lhs->as<USize>()->value);
+
           for( USize::ValueType i = 0; i < lhs->as<USize>()->value; i++ )
-            for( auto&& c : rhs->as<String>()->value )
-              obj->value.emplace_back(c->clone());
+            obj->value += rhs->as<String>()->value;
 
           return obj;
         }
@@ -472,25 +508,25 @@ Object* obj_rshift(AST::Expr* expr, Object* lhs, Object* rhs) {
 }
 
 /*
- * obj_bigger
+ * cmp_bigger
+ *   "lhs > rhs" without making a Bool object.
+ *   --> std::nullopt if can't compare
  */
-Object* obj_bigger(AST::Expr* expr, Object* lhs, Object* rhs) {
-  (void)expr;
-
+std::optional<bool> cmp_bigger(Object* lhs, Object* rhs) {
   switch( lhs->type.kind ) {
     case TypeInfo::Int:
       switch( rhs->type.kind ) {
         // int > int
         case TypeInfo::Int:
-          return new Bool(lhs->as<Int>()->value > rhs->as<Int>()->value);
+          return lhs->as<Int>()->value > rhs->as<Int>()->value;
 
         // int > float
         case TypeInfo::Float:
-          return new Bool(lhs->as<Int>()->value > (Int::ValueType)rhs->as<Float>()->value);
+          return lhs->as<Int>()->value > (Int::ValueType)rhs->as<Float>()->value;
 
         // int > usize
         case TypeInfo::USize:
-          return new Bool(lhs->as<Int>()->value > (Int::ValueType)rhs->as<USize>()->value);
+          return lhs->as<Int>()->value > (Int::ValueType)rhs->as<USize>()->value;
       }
       break;
 
@@ -498,15 +534,15 @@ Object* obj_bigger(AST::Expr* expr, Object* lhs, Object* rhs) {
       switch( rhs->type.kind ) {
         // float > int
         case TypeInfo::Int:
-          return new Bool(lhs->as<Float>()->value > rhs->as<Int>()->value);
+          return lhs->as<Float>()->value > rhs->as<Int>()->value;
 
         // float > float
         case TypeInfo::Float:
-          return new Bool(lhs->as<Float>()->value > (Float::ValueType)rhs->as<Float>()->value);
+          return lhs->as<Float>()->value > (Float::ValueType)rhs->as<Float>()->value;
 
         // float > usize
         case TypeInfo::USize:
-          return new Bool(lhs->as<Float>()->value > (Float::ValueType)rhs->as<USize>()->value);
+          return lhs->as<Float>()->value > (Float::ValueType)rhs->as<USize>()->value;
       }
       break;
 
@@ -514,42 +550,41 @@ Object* obj_bigger(AST::Expr* expr, Object* lhs, Object* rhs) {
       switch( rhs->type.kind ) {
         // usize > int
         case TypeInfo::Int:
-          return new Bool(lhs->as<USize>()->value > (unsigned)rhs->as<Int>()->value);
+          return lhs->as<USize>()->value > (unsigned)rhs->as<Int>()->value;
 
         // usize > float
         case TypeInfo::Float:
-          return new Bool(lhs->as<USize>()->value > (USize::ValueType)rhs->as<Float>()->value);
+          return lhs->as<USize>()->value > (USize::ValueType)rhs->as<Float>()->value;
 
         // usize > usize
         case TypeInfo::USize:
-          return new Bool(lhs->as<USize>()->value > (USize::ValueType)rhs->as<USize>()->value);
+          return lhs->as<USize>()->value > (USize::ValueType)rhs->as<USize>()->value;
       }
       break;
   }
 
-  return nullptr;
+  return std::nullopt;
 }
 
 /*
- * obj_bigger_or_equal
+ * cmp_bigger_or_equal
+ *   "lhs >= rhs" without making a Bool object.
  */
-Object* obj_bigger_or_equal(AST::Expr* expr, Object* lhs, Object* rhs) {
-  (void)expr;
-
+std::optional<bool> cmp_bigger_or_equal(Object* lhs, Object* rhs) {
   switch( lhs->type.kind ) {
     case TypeInfo::Int:
       switch( rhs->type.kind ) {
         // int >= int
         case TypeInfo::Int:
-          return new Bool(lhs->as<Int>()->value >= rhs->as<Int>()->value);
+          return lhs->as<Int>()->value >= rhs->as<Int>()->value;
 
         // int >= float
         case TypeInfo::Float:
-          return new Bool(lhs->as<Int>()->value >= (Int::ValueType)rhs->as<Float>()->value);
+          return lhs->as<Int>()->value >= (Int::ValueType)rhs->as<Float>()->value;
 
         // int >= usize
         case TypeInfo::USize:
-          return new Bool(lhs->as<Int>()->value >= (Int::ValueType)rhs->as<USize>()->value);
+          return lhs->as<Int>()->value >= (Int::ValueType)rhs->as<USize>()->value;
       }
       break;
 
@@ -557,15 +592,15 @@ Object* obj_bigger_or_equal(AST::Expr* expr, Object* lhs, Object* rhs) {
       switch( rhs->type.kind ) {
         // float >= int
         case TypeInfo::Int:
-          return new Bool(lhs->as<Float>()->value >= rhs->as<Int>()->value);
+          return lhs->as<Float>()->value >= rhs->as<Int>()->value;
 
         // float >= float
         case TypeInfo::Float:
-          return new Bool(lhs->as<Float>()->value >= (Float::ValueType)rhs->as<Float>()->value);
+          return lhs->as<Float>()->value >= (Float::ValueType)rhs->as<Float>()->value;
 
         // float >= usize
         case TypeInfo::USize:
-          return new Bool(lhs->as<Float>()->value >= (Float::ValueType)rhs->as<USize>()->value);
+          return lhs->as<Float>()->value >= (Float::ValueType)rhs->as<USize>()->value;
       }
       break;
 
@@ -573,19 +608,43 @@ Object* obj_bigger_or_equal(AST::Expr* expr, Object* lhs, Object* rhs) {
       switch( rhs->type.kind ) {
         // usize >= int
         case TypeInfo::Int:
-          return new Bool(lhs->as<USize>()->value >= (unsigned)rhs->as<Int>()->value);
+          return lhs->as<USize>()->value >= (unsigned)rhs->as<Int>()->value;
 
         // usize >= float
         case TypeInfo::Float:
-          return new Bool(lhs->as<USize>()->value >= (USize::ValueType)rhs->as<Float>()->value);
+          return lhs->as<USize>()->value >= (USize::ValueType)rhs->as<Float>()->value;
 
         // usize >= usize
         case TypeInfo::USize:
-          return new Bool(lhs->as<USize>()->value >= (USize::ValueType)rhs->as<USize>()->value);
+          return lhs->as<USize>()->value >= (USize::ValueType)rhs->as<USize>()->value;
       }
       break;
   }
 
+  return std::nullopt;
+}
+
+/*
+ * obj_bigger
+ */
+Object* obj_bigger(AST::Expr* expr, Object* lhs, Object* rhs) {
+  (void)expr;
+
+  if( auto res = cmp_bigger(lhs, rhs); res )
+    return new Bool(*res);
+
+  return nullptr;
+}
+
+/*
+ * obj_bigger_or_equal
+ */
+Object* obj_bigger_or_equal(AST::Expr* expr, Object* lhs, Object* rhs) {
+  (void)expr;
+
+  if( auto res = cmp_bigger_or_equal(lhs, rhs); res )
+    return new Bool(*res);
+
   return nullptr;
 }
 
@@ -746,16 +805,182 @@ Object* Evaluator::evalOperator(AST::Expr* expr) {
   GC::unbind(lhs);
   GC::unbind(rhs);
 
-  if( !result ) {
-    Error(expr->token)
-      .setMessage(
-        "invalid operator: '" + lhs->type.to_string() + "' "
-          + std::string(expr->token->str) + " '" + rhs->type.to_string() + "'")
+  if( !result )
+    invalidOperator(expr, lhs, rhs);
+
+  return result;
+}
+
+//
+// === evalSelfAppend ===
+//
+//  "s = s + x" where s is a local string or bytes.
+//  reading a variable makes a copy, so the object of s is owned only by
+//  the variable, and x can be appended to it in place without the copy.
+//  a literal is shared by all evaluations, so it is copied at first.
+//
+//  only for a statement, since the value of the assignment would be the
+//  object of s itself, and later appends would be visible through it.
+//
+//  returns false if "assign" is not this form.
+//
+bool Evaluator::evalSelfAppend(AST::Expr* assign) {
+  if( assign->left->kind != ASTKind::Variable || assign->right->kind != ASTKind::Add )
+    return false;
+
+  auto add = assign->right->as<AST::Expr>();
+  auto name = assign->left->as<AST::Variable>()->getSymbol();
+
+  if( add->left->kind != ASTKind::Variable || add->left->as<AST::Variable>()->getSymbol() != name )
+    return false;
+
+  auto pvar = this->findVariable(name, false);
+
+  if( !pvar || !*pvar )
+    return false;
+
+  switch( (*pvar)->type.kind ) {
+    case TypeInfo::String:
+    case TypeInfo::Bytes:
+      break;
+
+    default:
+      return false;
+  }
+
+  auto saved = *pvar;
+  auto literal = saved->noDelete;
+
+  // kept by GC even if s is rebound in x
+  saved->noDelete = true;
+
+  auto value = this->eval(add->right);
+
+  // find again, the storage may be moved by calls in x
+  auto& dest = *this->findVariable(name);
+
+  // append in place only if s still has the object
+  if( dest == saved ) {
+    saved->noDelete = literal;
+
+    if( literal ) {
+      GC::unbind(dest);
+      GC::bind(dest = dest->clone());
+    }
+
+    switch( dest->type.kind ) {
+      case TypeInfo::String:
+        if( value->type.kind == TypeInfo::Char ) {
+          dest->as<String>()->value.push_back(value->as<Char>()->value);
+          return true;
+        }
+
+        if( value->type.kind == TypeInfo::String ) {
+          dest->as<String>()->value.append(value->as<String>()->value);
+          return true;
+        }
+
+        break;
+
+      case TypeInfo::Bytes:
+        if( value->type.kind == TypeInfo::Bytes ) {
+          // copy first, the buffer of x may be same one
+          auto src = value->as<Bytes>()->get();
+          auto& buf = dest->as<Bytes>()->getMutable();
+
+          buf.insert(buf.end(), src.begin(), src.end());
+
+          return true;
+        }
+
+        break;
+    }
+  }
+
+  // not appendable, or s is rebound in x: same as without this
+  auto lhs = saved->clone();
+
+  saved->noDelete = literal;
+
+  GC::bind(lhs);
+  GC::bind(value);
+
+  auto result = obj_add(add, lhs, value);
+
+  GC::unbind(lhs);
+  GC::unbind(value);
+
+  if( !result )
+    invalidOperator(add, lhs, value);
+
+  GC::unbind(dest);
+  GC::bind(dest = result);
+
+  return true;
+}
+
+//
+// === evalCondition ===
+//
+//  "&&" and "||" are short-circuited, and comparisons are evaluated into
+//  a native bool directly, so no Bool object is made for a condition.
+//
+bool Evaluator::evalCondition(AST::Base* ast) {
+  switch( ast->kind ) {
+    case ASTKind::LogAND: {
+      auto x = ast->as<AST::Expr>();
+
+      return this->evalCondition(x->left) && this->evalCondition(x->right);
+    }
+
+    case ASTKind::LogOR: {
+      auto x = ast->as<AST::Expr>();
+
+      return this->evalCondition(x->left) || this->evalCondition(x->right);
+    }
+
+    case ASTKind::Not:
+      return !this->evalCondition(ast->as<AST::Expr>()->left);
+
+    case ASTKind::Equal: {
+      auto x = ast->as<AST::Expr>();
+
+      return this->evalOperand(x->left)->equals(this->evalOperand(x->right));
+    }
+
+    case ASTKind::Bigger:
+    case ASTKind::BiggerOrEqual: {
+      auto x = ast->as<AST::Expr>();
+
+      auto lhs = this->evalOperand(x->left);
+      auto rhs = this->evalOperand(x->right);
+
+      auto result =
+        ast->kind == ASTKind::Bigger ? cmp_bigger(lhs, rhs) : cmp_bigger_or_equal(lhs, rhs);
+
+      if( !result ) {
+        Error(x->token)
+          .setMessage(
+            "invalid operator: '" + lhs->type.to_string() + "' "
+              + std::string(x->token->str) + " '" + rhs->type.to_string() + "'")
+          .emit()
+          .exit();
+      }
+
+      return *result;
+    }
+  }
+
+  auto obj = this->evalOperand(ast);
+
+  if( obj->type.kind != TypeInfo::Bool ) {
+    Error(ast)
+      .setMessage("expected boolean expression")
       .emit()
       .exit();
   }
 
-  return result;
+  return obj->as<Bool>()->value;
 }
 
 } // namespace metro
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include <iostream>
 #include <sstream>
+#include <optional>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
 #include "alert.h"
 #include "BuiltinFunc.h"
 #include "Evaluator.h"
@@ -14,6 +18,308 @@ namespace metro {
 
 using namespace objects;
 
+namespace {
+
+/*
+ * forEachChild
+ *   call "fn" with every direct child node of "ast".
+ */
+template <class F>
+void forEachChild(AST::Base* ast, F&& fn) {
+  if( !ast )
+    return;
+
+  switch( ast->kind ) {
+    case ASTKind::CallFunc:
+    case ASTKind::New:
+      for( auto&& arg : ast->as<AST::CallFunc>()->arguments )
+        fn(arg);
+
+      break;
+
+    case ASTKind::Array:
+    case ASTKind::Tuple:
+      for( auto&& e : ast->as<AST::Array>()->elements )
+        fn(e);
+
+      break;
+
+    case ASTKind::Scope:
+      for( auto&& x : ast->as<AST::Scope>()->list )
+        fn(x);
+
+      break;
+
+    case ASTKind::If: {
+      auto x = ast->as<AST::If>();
+
+      fn(x->cond);
+      fn(x->case_true);
+      fn(x->case_false);
+
+      break;
+    }
+
+    case ASTKind::Switch: {
+      auto x = ast->as<AST::Switch>();
+
+      fn(x->expr);
+
+      for( auto&& c : x->cases ) {
+        fn(c.to_compare);
+        fn(c.scope);
+      }
+
+      break;
+    }
+
+    case ASTKind::Loop:
+    case ASTKind::While:
+    case ASTKind::DoWhile:
+      fn(ast->as<AST::While>()->cond);
+      fn(ast->as<AST::While>()->code);
+      break;
+
+    case ASTKind::For: {
+      auto x = ast->as<AST::For>();
+
+      fn(x->iter);
+      fn(x->content);
+      fn(x->code);
+
+      break;
+    }
+
+    case ASTKind::Value:
+    case ASTKind::Variable:
+    case ASTKind::Function:
+    case ASTKind::Enum:
+    case ASTKind::Struct:
+    case ASTKind::Class:
+      break;
+
+    default:
+      fn(ast->as<AST::Expr>()->left);
+      fn(ast->as<AST::Expr>()->right);
+      break;
+  }
+}
+
+bool isVariable(AST::Base* ast, SymbolID name) {
+  return ast && ast->kind == ASTKind::Variable && ast->as<AST::Variable>()->getSymbol() == name;
+}
+
+/*
+ * the variable that is rebound when "ast" is written as lvalue.
+ *   "v = x"   --> v
+ *   "v.m = x" --> v
+ *   "v[i] = x" --> nothing (only the element is replaced)
+ */
+AST::Variable* getReboundVariable(AST::Base* ast) {
+  switch( ast->kind ) {
+    case ASTKind::Variable:
+      return ast->as<AST::Variable>();
+
+    case ASTKind::MemberAccess:
+      return getReboundVariable(ast->as<AST::Expr>()->left);
+  }
+
+  return nullptr;
+}
+
+/*
+ * true if "ast" rebinds the variable "name".
+ */
+bool isRebinding(AST::Base* ast, SymbolID name) {
+  if( !ast )
+    return false;
+
+  AST::Base* dest = nullptr;
+
+  if( ast->kind == ASTKind::Assignment )
+    dest = ast->as<AST::Expr>()->left;
+  else if( ast->kind == ASTKind::For )
+    dest = ast->as<AST::For>()->iter;
+
+  if( dest ) {
+    if( auto var = getReboundVariable(dest); var && var->getSymbol() == name )
+      return true;
+  }
+
+  bool ret = false;
+
+  forEachChild(ast, [&] (AST::Base* child) {
+    ret = ret || isRebinding(child, name);
+  });
+
+  return ret;
+}
+
+void markInBounds(AST::Base* ast, SymbolID obj, SymbolID index) {
+  if( !ast )
+    return;
+
+  if( ast->kind == ASTKind::IndexRef ) {
+    auto x = ast->as<AST::IndexRef>();
+
+    if( isVariable(x->left, obj) && isVariable(x->right, index) )
+      x->isInBounds = true;
+  }
+
+  forEachChild(ast, [&] (AST::Base* child) {
+    markInBounds(child, obj, index);
+  });
+}
+
+/*
+ * key of switch-case for jump table.
+ *   int, char   --> the value
+ *   enumerator  --> the immediate tagged with id of enum
+ */
+std::optional<int64_t> getSwitchKey(Object* obj) {
+  switch( obj->type.kind ) {
+    case TypeInfo::Int:
+      return obj->as<Int>()->value;
+
+    case TypeInfo::Char:
+      return obj->as<Char>()->value;
+
+    case TypeInfo::Enumerator:
+      return obj->as<Enumerator>()->getKey();
+  }
+
+  return std::nullopt;
+}
+
+} // anonymous namespace
+
+//
+// === analyzeSwitch ===
+//
+//  if all of cases are literals or enumerators of same type and can be a
+//  key of the jump table, dispatch with the table.
+//  otherwise compare with each case.
+//
+void Evaluator::analyzeSwitch(AST::Switch* ast) {
+  using Dispatch = AST::Switch::Dispatch;
+
+  std::vector<std::pair<int64_t, AST::Switch::Case*>> keys;
+
+  ast->dispatch = Dispatch::Linear;
+
+  for( auto&& c : ast->cases ) {
+    if( !c.to_compare )
+      ast->defaultCase = &c;
+  }
+
+  for( auto&& c : ast->cases ) {
+    if( !c.to_compare )
+      continue;
+
+    Object* obj = nullptr;
+
+    if( c.to_compare->kind == ASTKind::Value )
+      obj = c.to_compare->as<AST::Value>()->object;
+    else if( c.to_compare->kind == ASTKind::MemberAccess )
+      obj = this->findEnumerator(c.to_compare->as<AST::MemberAccess>());
+
+    if( !obj )
+      return;
+
+    auto key = getSwitchKey(obj);
+
+    if( !key || (!keys.empty() && obj->type.kind != ast->keyKind) )
+      return;
+
+    ast->keyKind = obj->type.kind;
+    keys.emplace_back(*key, &c);
+  }
+
+  if( keys.empty() )
+    return;
+
+  auto [min, max] = std::minmax_element(keys.begin(), keys.end());
+  auto width = (uint64_t)(max->first - min->first) + 1;
+
+  // dense
+  if( width <= keys.size() * 2 + 8 ) {
+    ast->dispatch = Dispatch::Table;
+    ast->tableBase = min->first;
+    ast->table.resize(width, nullptr);
+
+    for( auto&& [key, c] : keys ) {
+      auto& slot = ast->table[key - ast->tableBase];
+
+      if( slot ) {
+        Error(c->to_compare)
+          .setMessage("duplicated case")
+          .emit()
+          .exit();
+      }
+
+      slot = c;
+    }
+
+    return;
+  }
+
+  // sparse
+  ast->dispatch = Dispatch::Hash;
+
+  for( auto&& [key, c] : keys ) {
+    if( !ast->hashTable.emplace(key, c).second ) {
+      Error(c->to_compare)
+        .setMessage("duplicated case")
+        .emit()
+        .exit();
+    }
+  }
+}
+
+//
+// === analyzeLoopBounds ===
+//
+//  for i in <begin> .. v.count { ... v[i] ... }
+//
+//  if <begin> is a non-negative literal, then "i" is always in [0, v.count)
+//  while the body doesn't rebind "i" or "v".
+//
+void Evaluator::analyzeLoopBounds(AST::For* ast) {
+  ast->isAnalyzed = true;
+
+  if( ast->iter->kind != ASTKind::Variable || ast->content->kind != ASTKind::Range )
+    return;
+
+  auto range = ast->content->as<AST::Expr>();
+
+  // begin
+  if( range->left->kind != ASTKind::Value )
+    return;
+
+  auto begin = range->left->as<AST::Value>()->object;
+
+  if( !(begin->type.kind == TypeInfo::USize
+      || (begin->type.kind == TypeInfo::Int && begin->as<Int>()->value >= 0)) )
+    return;
+
+  // end
+  if( range->right->kind != ASTKind::MemberAccess )
+    return;
+
+  auto end = range->right->as<AST::Expr>();
+
+  if( end->left->kind != ASTKind::Variable || !isVariable(end->right, Sym::Count) )
+    return;
+
+  auto index = ast->iter->as<AST::Variable>()->getSymbol();
+  auto obj = end->left->as<AST::Variable>()->getSymbol();
+
+  if( index == obj || isRebinding(ast->code, index) || isRebinding(ast->code, obj) )
+    return;
+
+  markInBounds(ast->code, obj, index);
+}
+
 void Evaluator::evalStatements(AST::Base* ast) {
   LABEL_TABLE {
     &&_eval_scope,
@@ -31,46 +337,26 @@ void Evaluator::evalStatements(AST::Base* ast) {
   goto *_labels[static_cast<int>(ast->kind) - static_cast<int>(ASTKind::Scope)];
 
   _eval_scope: {
-    auto scope = ast->as<AST::Scope>();
-
-    ScopeEvaluationFlags
-      flags, *save = this->_scope;
-
-    this->_scope = &flags;
-
-    for( auto&& x : scope->list ) {
-      this->eval(x);
-
-      if( this->inFunction() ) {
-          if( this->getCurrentCallStack().isReturned ) {
-          break;
-        }
+    for( auto&& x : ast->as<AST::Scope>()->list ) {
+      if( x->kind == ASTKind::Assignment ) {
+        // "s = s + x" --> append to s in place
+        if( !this->evalSelfAppend(x->as<AST::Expr>()) )
+          this->evalAssignment(x->as<AST::Expr>());
       }
+      else
+        this->eval(x);
 
-      if( _loopScope ) {
-        if( _loopScope->isBreaked || _loopScope->isContinued )
-          break;
-      }
+      if( this->interrupt != Interrupt::None )
+        break;
     }
 
-    this->_scope = save;
-
     goto _end;
   }
 
   _eval_if: {
     auto x = ast->as<AST::If>();
 
-    auto cond = this->eval(x->cond);
-
-    if( !cond->type.equals(TypeInfo::Bool) ) {
-      Error(x->cond)
-        .setMessage("expected boolean expression")
-        .emit()
-        .exit();
-    }
-
-    if( cond->as<Bool>()->value )
+    if( this->evalCondition(x->cond) )
       this->eval(x->case_true);
     else if( x->case_false )
       this->eval(x->case_false);
@@ -79,9 +365,54 @@ void Evaluator::evalStatements(AST::Base* ast) {
   }
 
   _eval_switch: {
-    auto sw = ast->as<AST::Switch>();
+    auto x = ast->as<AST::Switch>();
+
+    if( x->dispatch == AST::Switch::Dispatch::Unknown )
+      this->analyzeSwitch(x);
+
+    auto value = this->evalOperand(x->expr);
+    AST::Switch::Case* matched = nullptr;
+
+    switch( x->dispatch ) {
+      case AST::Switch::Dispatch::Table: {
+        if( value->type.kind != x->keyKind )
+          break;
+
+        auto index = (uint64_t)(*getSwitchKey(value) - x->tableBase);
+
+        if( index < x->table.size() )
+          matched = x->table[index];
+
+        break;
+      }
 
-    (void)sw;
+      case AST::Switch::Dispatch::Hash: {
+        if( value->type.kind != x->keyKind )
+          break;
+
+        if( auto it = x->hashTable.find(*getSwitchKey(value)); it != x->hashTable.end() )
+          matched = it->second;
+
+        break;
+      }
+
+      default: {
+        for( auto&& c : x->cases ) {
+          if( c.to_compare && value->equals(this->evalOperand(c.to_compare)) ) {
+            matched = &c;
+            break;
+          }
+        }
+
+        break;
+      }
+    }
+
+    if( !matched )
+      matched = x->defaultCase;
+
+    if( matched )
+      this->eval(matched->scope);
 
     goto _end;
   }
@@ -94,52 +425,64 @@ void Evaluator::evalStatements(AST::Base* ast) {
         .exit();
     }
 
-    auto& stack = this->getCurrentCallStack();
-
-    stack.isReturned = true;
-
     if( auto expr = ast->as<AST::Expr>()->left; expr )
-      stack.result = this->eval(expr);
+      this->getCurrentCallStack().result = this->eval(expr);
+
+    this->interrupt = Interrupt::Return;
 
     goto _end;
   }
   
   _eval_break:
-    todo_impl;
+    this->interrupt = Interrupt::Break;
+    goto _end;
   
   _eval_continue:
-    todo_impl;
+    this->interrupt = Interrupt::Continue;
+    goto _end;
   
-  _eval_loop:
-    todo_impl;
+  _eval_loop: {
+    auto x = ast->as<AST::While>();
+
+    do {
+      this->eval(x->code);
+    } while( !this->isLoopInterrupted() );
+
+    goto _end;
+  }
   
   _eval_while: {
     auto x = ast->as<AST::While>();
 
-    while( true ) {
-      auto cond = this->eval(x->cond);
+    while( this->evalCondition(x->cond) ) {
+      this->eval(x->code);
 
-      if( !cond->type.equals(TypeInfo::Bool) )
-        Error(x->cond)
-          .setMessage("expected boolean expression")
-          .emit()
-          .exit();
-      
-      if( !cond->as<Bool>()->value )
+      if( this->isLoopInterrupted() )
         break;
-
-      this->eval(x->code);
     }
 
     goto _end;
   }
   
-  _eval_do_while:
-    todo_impl;
+  _eval_do_while: {
+    auto x = ast->as<AST::While>();
+
+    do {
+      this->eval(x->code);
+
+      if( this->isLoopInterrupted() )
+        break;
+    } while( this->evalCondition(x->cond) );
+
+    goto _end;
+  }
 
   _eval_for: {
     auto x = ast->as<AST::For>();
 
+    if( !x->isAnalyzed )
+      this->analyzeLoopBounds(x);
+
     // if already defined variable with same name of iterator, save object of that.
     Object* save_iter_value = nullptr;
     Object** saved_var_ptr = nullptr;
@@ -164,8 +507,11 @@ void Evaluator::evalStatements(AST::Base* ast) {
         auto _Str = content->as<String>();
 
         for( auto&& _Char : _Str->value ) {
-          iter = _Char;
+          iter = new Char(_Char);
           this->eval(x->code);
+
+          if( this->isLoopInterrupted() )
+            break;
         }
 
         break;
@@ -177,6 +523,9 @@ void Evaluator::evalStatements(AST::Base* ast) {
         for( auto&& _Elem : _Vec->elements ) {
           iter = _Elem;
           this->eval(x->code);
+
+          if( this->isLoopInterrupted() )
+            break;
         }
 
         break;
@@ -191,10 +540,72 @@ void Evaluator::evalStatements(AST::Base* ast) {
 
         for( iter = new Int(range->begin); iter->as<Int>()->value < range->end; iter->as<Int>()->value++ ) {
           this->eval(x->code);
+
+          if( this->isLoopInterrupted() )
+            break;
+        }
+
+        break;
+      }
+
+      case TypeInfo::Bytes: {
+        auto _Bytes = content->as<Bytes>();
+
+        for( size_t i = 0; i < _Bytes->get().size(); i++ ) {
+          iter = new Int(_Bytes->get()[i]);
+          this->eval(x->code);
+
+          if( this->isLoopInterrupted() )
+            break;
         }
 
         break;
       }
+
+      // read one line at a time
+      case TypeInfo::Lines: {
+        auto lines = content->as<Lines>();
+        auto file = lines->file;
+        int fd;
+
+        if( !file ) {
+          if( (fd = ::open(lines->path.c_str(), O_RDONLY | O_CLOEXEC)) < 0 ) {
+            Error(x->content)
+              .setMessage("cannot open file '" + lines->path + "'")
+              .emit()
+              .exit();
+          }
+        }
+        else if( !file->isOpen() || file->mode != File::Mode::Read ) {
+          Error(x->content)
+            .setMessage("file '" + file->path + "' is not opened for reading")
+            .emit()
+            .exit();
+        }
+        else
+          fd = file->fd;
+
+        // keep the file open while iterating
+        GC::bind(lines);
+
+        utils::LineReader reader{ fd };
+
+        for( std::string_view line; reader.next(line); ) {
+          iter = new String(utils::decode_utf8(line));
+          this->eval(x->code);
+
+          if( this->isLoopInterrupted() )
+            break;
+        }
+
+        GC::unbind(lines);
+
+        // opened by this loop
+        if( !file )
+          ::close(fd);
+
+        break;
+      }
     }
 
     // restore if saved
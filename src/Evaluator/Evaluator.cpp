@@ -3,6 +3,7 @@
 #include "alert.h"
 #include "BuiltinFunc.h"
 #include "Evaluator.h"
+#include "Parser.h"
 #include "GC.h"
 #include "Utils.h"
 #include "Error.h"
@@ -13,10 +14,21 @@ using namespace objects;
 
 Evaluator::Evaluator(AST::Scope* rootScope)
   : rootScope(rootScope),
-    _loopScope(nullptr),
-    _funcScope(nullptr),
-    _scope(nullptr)
+    interrupt(Interrupt::None),
+    elementRef(nullptr)
 {
+  for( auto&& ast : rootScope->list ) {
+    if( ast->kind == ASTKind::Enum ) {
+      auto E = ast->as<AST::Enum>();
+
+      if( !this->enums.emplace(E->getSymbol(), E).second ) {
+        Error(E->nameToken)
+          .setMessage("redefinition of enum '" + std::string(E->getName()) + "'")
+          .emit()
+          .exit();
+      }
+    }
+  }
 }
 
 //
@@ -36,19 +48,7 @@ Object* Evaluator::eval(AST::Base* ast) {
     }
 
     case ASTKind::Variable: {
-      auto var = ast->as<AST::Variable>();
-      auto pvar = this->getCurrentStorage()[var->getName()];
-
-      if( this->inFunction() && !pvar )
-        pvar = this->globalStorage[var->getName()];
-
-      if( !pvar )
-        Error(ast)
-          .setMessage("variable '" + std::string(ast->token->str) +"' is not defined")
-          .emit()
-          .exit();
-
-      return pvar->clone();
+      return this->evalOperand(ast)->clone();
     }
 
     case ASTKind::Array: {
@@ -99,11 +99,11 @@ Object* Evaluator::eval(AST::Base* ast) {
     case ASTKind::New: {
       auto x = ast->as<AST::CallFunc>();
 
-      auto S = this->findStruct(x->getName());
+      auto S = this->findStruct(x->getSymbol());
 
       if( !S ) {
         Error(x->token)
-          .setMessage("struct '" + x->getName() + "' is not defined")
+          .setMessage("struct '" + std::string(x->getName()) + "' is not defined")
           .emit()
           .exit();
       }
@@ -123,7 +123,7 @@ Object* Evaluator::eval(AST::Base* ast) {
       for( auto it = S->members.begin(); auto&& arg : x->arguments ) {
         auto init = arg->as<AST::Expr>();
 
-        if( (*it++)->str != init->left->token->str )
+        if( (*it++)->sym != init->left->token->sym )
           Error(init)
             .setMessage("expected initializer for member '" + std::string((*it)->str) + "'")
             .emit()
@@ -139,7 +139,7 @@ Object* Evaluator::eval(AST::Base* ast) {
     // index ref
     //
     case ASTKind::IndexRef: {
-      auto x = ast->as<AST::Expr>();
+      auto x = ast->as<AST::IndexRef>();
 
       return this->evalIndexRef(x, this->eval(x->left), this->eval(x->right));
     }
@@ -148,36 +148,64 @@ Object* Evaluator::eval(AST::Base* ast) {
     // member access
     //
     case ASTKind::MemberAccess: {
-      auto x = ast->as<AST::Expr>();
+      auto x = ast->as<AST::MemberAccess>();
 
-      auto obj = this->eval(x->left);
+      // enumerator
+      if( auto e = this->findEnumerator(x); e )
+        return e;
+
+      // not cloned, only to read a member
+      auto obj = this->evalOperand(x->left);
       std::string name;
 
       if( x->right->kind == ASTKind::Variable ) {
         auto member = x->right->as<AST::Variable>();
+        auto sym = member->getSymbol();
+
         name = member->getName();
 
         switch( obj->type.kind ) {
           case TypeInfo::Int: {
-            if( name == "abs" )
+            if( sym == Sym::Abs )
               return new Int(std::abs(obj->as<Int>()->value));
 
             break;
           }
 
           case TypeInfo::String: {
-            if( name == "count" )
+            if( sym == Sym::Count )
               return new USize(obj->as<String>()->value.size());
 
             break;
           }
 
+          case TypeInfo::Vector: {
+            if( sym == Sym::Count )
+              return new USize(obj->as<Vector>()->elements.size());
+
+            break;
+          }
+
+          case TypeInfo::Bytes: {
+            if( sym == Sym::Count )
+              return new USize(obj->as<Bytes>()->get().size());
+
+            break;
+          }
+
+          case TypeInfo::StringBuilder: {
+            if( sym == Sym::Count )
+              return new USize(obj->as<StringBuilder>()->value.size());
+
+            break;
+          }
+
           case TypeInfo::Struct: {
             auto S = obj->type.ast_struct;
 
             for( size_t i = 0; i < S->members.size(); i++ ) {
-              if( S->members[i]->str == name )
-                return obj->as<Vector>()->elements[i];
+              if( S->members[i]->sym == sym )
+                return obj->as<Vector>()->elements[i]->clone();
             }
 
             break;
@@ -202,19 +230,7 @@ Object* Evaluator::eval(AST::Base* ast) {
     // not
     //
     case ASTKind::Not: {
-      auto x = ast->as<AST::Expr>();
-
-      auto obj = this->eval(x->left);
-
-      if( !obj->type.equals(TypeInfo::Bool) ) {
-        Error(x->left)
-          .setMessage("expected boolean expression")
-          .emit()
-          .exit();
-      }
-
-      obj->as<Bool>()->value ^= 1;
-      return obj;
+      return new Bool(!this->evalCondition(ast->as<AST::Expr>()->left));
     }
 
     //
@@ -223,7 +239,7 @@ Object* Evaluator::eval(AST::Base* ast) {
     case ASTKind::Equal: {
       auto x = ast->as<AST::Expr>();
 
-      return new Bool(this->eval(x->left)->equals(this->eval(x->right)));
+      return new Bool(this->evalOperand(x->left)->equals(this->evalOperand(x->right)));
     }
 
     //
@@ -231,29 +247,7 @@ Object* Evaluator::eval(AST::Base* ast) {
     //
     case ASTKind::LogAND:
     case ASTKind::LogOR: {
-      auto x = ast->as<AST::Expr>();
-
-      auto lhs = this->eval(x->left);
-      auto rhs = this->eval(x->right);
-
-      if( !lhs->type.equals(TypeInfo::Bool) ) {
-        Error(x->left)
-          .setMessage("expected boolean expression")
-          .emit()
-          .exit();
-      }
-
-      if( !rhs->type.equals(TypeInfo::Bool) ) {
-        Error(x->right)
-          .setMessage("expected boolean expression")
-          .emit()
-          .exit();
-      }
-
-      if( ast->kind == ASTKind::LogAND )
-        return new Bool(lhs->as<Bool>()->value && rhs->as<Bool>()->value);
-
-      return new Bool(lhs->as<Bool>()->value || rhs->as<Bool>()->value);
+      return new Bool(this->evalCondition(ast));
     }
 
     //
@@ -265,46 +259,43 @@ Object* Evaluator::eval(AST::Base* ast) {
       auto begin = this->eval(x->left);
       auto end = this->eval(x->right);
 
-      if( !begin->type.equals(TypeInfo::Int) )
-        Error(x->left)
-          .setMessage("expected 'int' object")
-          .emit()
-          .exit();
+      int64_t values[2] { };
 
-      if( !end->type.equals(TypeInfo::Int) )
-        Error(x->right)
-          .setMessage("expected 'int' object")
-          .emit()
-          .exit();
+      for( int i = 0; auto&& obj : { begin, end } ) {
+        switch( obj->type.kind ) {
+          case TypeInfo::Int:
+            values[i] = obj->as<Int>()->value;
+            break;
 
-      if( begin->as<Int>()->value >= end->as<Int>()->value ) {
+          case TypeInfo::USize:
+            values[i] = (int64_t)obj->as<USize>()->value;
+            break;
+
+          default:
+            Error(i == 0 ? x->left : x->right)
+              .setMessage("expected 'int' or 'usize' object")
+              .emit()
+              .exit();
+        }
+
+        i++;
+      }
+
+      if( values[0] >= values[1] ) {
         Error(x)
           .setMessage("start value must less than end").emit().exit();
       }
 
-      return new Range(begin->as<Int>()->value, end->as<Int>()->value);
+      return new Range(values[0], values[1]);
     }
  
     //
     // assign
     //
-    case ASTKind::Assignment: {
-      auto assign = ast->as<AST::Expr>();
-
-      auto value = this->eval(assign->right);
-
-      if( assign->left->kind == ASTKind::Variable ) {
-        auto& storage = this->getCurrentStorage();
-        auto name = assign->left->as<AST::Variable>()->getName();
-
-        if( !storage.contains(name) )
-          GC::bind(value);
-        else
-          GC::unbind(storage[name]);
-      }
-
-      return this->evalAsLeft(assign->left) = value;
-    }
+    case ASTKind::Assignment:
+      // copied, since the object of the destination may be appended
+      // in place by "s = s + x" later
+      return this->evalAssignment(ast->as<AST::Expr>())->clone();
 
     //
     // Statements
@@ -329,17 +320,109 @@ Object* Evaluator::eval(AST::Base* ast) {
   return None::getNone();
 }
 
+//
+// === evalAssignment ===
+//
+//  returns the object assigned, which is held by the destination.
+//
+Object* Evaluator::evalAssignment(AST::Expr* assign) {
+  auto value = this->eval(assign->right);
+
+  if( assign->left->kind == ASTKind::Variable ) {
+    auto& storage = this->getCurrentStorage();
+    auto name = assign->left->as<AST::Variable>()->getSymbol();
+
+    // the new value must be bound too, since "s = s + x" modifies it
+    if( storage.contains(name) )
+      GC::unbind(storage[name]);
+
+    GC::bind(value);
+  }
+
+  // string[index] = char
+  // bytes[index] = int
+  if( assign->left->kind == ASTKind::IndexRef ) {
+    auto x = assign->left->as<AST::IndexRef>();
+    auto obj = this->evalAsLeft(x->left);
+    auto index = this->evalIndex(x, obj, this->eval(x->right));
+
+    switch( obj->type.kind ) {
+      case TypeInfo::String:
+        if( value->type.kind != TypeInfo::Char ) {
+          Error(assign->right)
+            .setMessage("expected 'char' object")
+            .emit()
+            .exit();
+        }
+
+        obj->as<String>()->value[index] = value->as<Char>()->value;
+        return value;
+
+      case TypeInfo::Bytes:
+        if( value->type.kind != TypeInfo::Int ) {
+          Error(assign->right)
+            .setMessage("expected 'int' object")
+            .emit()
+            .exit();
+        }
+
+        if( value->as<Int>()->value < 0 || value->as<Int>()->value > 255 ) {
+          Error(assign->right)
+            .setMessage("byte value out of range (the value is "
+              + std::to_string(value->as<Int>()->value) + ")")
+            .emit()
+            .exit();
+        }
+
+        obj->as<Bytes>()->getMutable()[index] = (uint8_t)value->as<Int>()->value;
+        return value;
+    }
+
+    return obj->as<Vector>()->elements[index] = value;
+  }
+
+  return this->evalAsLeft(assign->left) = value;
+}
+
+//
+// === evalOperand ===
+//
+Object* Evaluator::evalOperand(AST::Base* ast) {
+  switch( ast->kind ) {
+    case ASTKind::Value:
+      return ast->as<AST::Value>()->object;
+
+    case ASTKind::Variable: {
+      auto var = ast->as<AST::Variable>();
+      auto pvar = this->getCurrentStorage()[var->getSymbol()];
+
+      if( this->inFunction() && !pvar )
+        pvar = this->globalStorage[var->getSymbol()];
+
+      if( !pvar )
+        Error(ast)
+          .setMessage("variable '" + std::string(ast->token->str) +"' is not defined")
+          .emit()
+          .exit();
+
+      return pvar;
+    }
+  }
+
+  return this->eval(ast);
+}
+
 //
 // === evalAsLeft ===
 //
 Object*& Evaluator::evalAsLeft(AST::Base* ast) {
   switch( ast->kind ) {
     case ASTKind::Variable: {
-      return *this->findVariable(ast->as<AST::Variable>()->getName());
+      return *this->findVariable(ast->as<AST::Variable>()->getSymbol());
     }
 
     case ASTKind::IndexRef: {
-      auto x = ast->as<AST::Expr>();
+      auto x = ast->as<AST::IndexRef>();
 
       return this->evalIndexRef(x, this->evalAsLeft(x->left), this->eval(x->right));
     }
@@ -357,9 +440,30 @@ Object*& Evaluator::evalAsLeft(AST::Base* ast) {
 //
 // === evalIndexRef ===
 //
-Object*& Evaluator::evalIndexRef(AST::Expr* ast, Object* obj, Object* objIndex) {
+Object*& Evaluator::evalIndexRef(AST::IndexRef* ast, Object* obj, Object* objIndex) {
+  auto index = this->evalIndex(ast, obj, objIndex);
+
+  // characters of string and bytes are not objects, so make a new one.
+  // (assignment to them is done in evaluating assignment)
+  switch( obj->type.kind ) {
+    case TypeInfo::String:
+      this->elementRef = new Char(obj->as<String>()->value[index]);
+      return this->elementRef;
+
+    case TypeInfo::Bytes:
+      this->elementRef = new Int(obj->as<Bytes>()->get()[index]);
+      return this->elementRef;
+  }
+
+  return obj->as<Vector>()->elements[index];
+}
+
+//
+// === evalIndex ===
+//
+size_t Evaluator::evalIndex(AST::IndexRef* ast, Object* obj, Object* objIndex) {
 
-  size_t index = 0;
+  int64_t index = 0;
 
   switch( objIndex->type.kind ) {
     case TypeInfo::Int:
@@ -367,7 +471,7 @@ Object*& Evaluator::evalIndexRef(AST::Expr* ast, Object* obj, Object* objIndex)
       break;
 
     case TypeInfo::USize:
-      index = objIndex->as<USize>()->value;
+      index = (int64_t)objIndex->as<USize>()->value;
       break;
 
     default:
@@ -377,24 +481,44 @@ Object*& Evaluator::evalIndexRef(AST::Expr* ast, Object* obj, Object* objIndex)
         .exit();
   }
 
+  size_t size = 0;
+
   switch( obj->type.kind ) {
-    case TypeInfo::String: {
-      return (Object*&)obj->as<String>()->value[index];
-    }
+    case TypeInfo::String:
+      size = obj->as<String>()->value.size();
+      break;
 
     case TypeInfo::Vector:
-      return obj->as<Vector>()->elements[index];
+      size = obj->as<Vector>()->elements.size();
+      break;
+
+    case TypeInfo::Bytes:
+      size = obj->as<Bytes>()->get().size();
+      break;
+
+    default:
+      Error(ast->right)
+        .setMessage("object of type '" + obj->type.to_string() + "' is not subscriptable")
+        .emit()
+        .exit();
   }
 
-  Error(ast->right)
-    .setMessage("object of type '" + obj->type.to_string() + "' is not subscriptable")
-    .emit()
-    .exit();
+  // bounds check
+  if( !ast->isInBounds && (index < 0 || (size_t)index >= size) ) {
+    Error(ast->right)
+      .setMessage(
+        "index out of range (the index is " + std::to_string(index)
+          + " but the size is " + std::to_string(size) + ")")
+      .emit()
+      .exit();
+  }
+
+  return (size_t)index;
 }
 
 Object* Evaluator::evalCallFunc(AST::CallFunc* ast, Object* self, std::vector<Object*>& args) {
 
-  auto [userdef, builtin] = this->findFunction(ast->getName(), self);
+  auto [userdef, builtin] = this->findFunction(ast->getSymbol(), self);
   auto name = std::string(ast->getName());
 
   if( self ) {
@@ -418,6 +542,23 @@ Object* Evaluator::evalCallFunc(AST::CallFunc* ast, Object* self, std::vector<Ob
       .exit();
   }
 
+  return this->callUserFunc(ast, userdef, args);
+}
+
+Object* Evaluator::callFunction(AST::CallFunc* ast, SymbolID name, std::vector<Object*>& args) {
+  auto [userdef, _] = this->findFunction(name, nullptr);
+
+  if( !userdef ) {
+    Error(ast->token)
+      .setMessage("undefined function name '" + std::string(SymbolTable::getName(name)) + "'")
+      .emit()
+      .exit();
+  }
+
+  return this->callUserFunc(ast, userdef, args);
+}
+
+Object* Evaluator::callUserFunc(AST::CallFunc* ast, AST::Function* userdef, std::vector<Object*>& args) {
   if( userdef->arguments.size() != args.size() ) {
     auto err = Error(ast->token);
 
@@ -434,11 +575,14 @@ Object* Evaluator::evalCallFunc(AST::CallFunc* ast, Object* self, std::vector<Ob
   auto& stack = this->push_stack(userdef);
 
   for( auto it = args.begin(); auto&& arg : userdef->arguments )
-    stack.storage[arg->str] = *it++;
+    stack.storage[arg->sym] = *it++;
+
+  this->eval(Parser::parseFunctionBody(userdef));
 
-  this->eval(userdef->scope);
+  this->interrupt = Interrupt::None;
 
-  auto result = stack.result;
+  // "stack" may be moved by the nested calls
+  auto result = this->getCurrentCallStack().result;
 
   this->pop_stack();
 
@@ -459,8 +603,22 @@ void Evaluator::pop_stack() {
   this->callStacks.pop_back();
 }
 
-Evaluator::ScopeEvaluationFlags& Evaluator::getCurrentScope() {
-  return *this->_scope;
+bool Evaluator::isLoopInterrupted() {
+  switch( this->interrupt ) {
+    case Interrupt::None:
+      return false;
+
+    case Interrupt::Continue:
+      this->interrupt = Interrupt::None;
+      return false;
+
+    case Interrupt::Break:
+      this->interrupt = Interrupt::None;
+      return true;
+  }
+
+  // return
+  return true;
 }
 
 bool Evaluator::inFunction() const {
@@ -478,7 +636,7 @@ Evaluator::Storage& Evaluator::getCurrentStorage() {
   return this->globalStorage;
 }
 
-Object** Evaluator::findVariable(std::string_view name, bool allowCreate) {
+Object** Evaluator::findVariable(SymbolID name, bool allowCreate) {
   auto& storage = this->getCurrentStorage();
 
   if( !storage.contains(name) && !allowCreate )
@@ -491,7 +649,7 @@ Object** Evaluator::findVariable(std::string_view name, bool allowCreate) {
 //
 // -- findFunction() --
 //
-std::tuple<AST::Function const*, builtin::BuiltinFunc const*> Evaluator::findFunction(std::string_view name, Object* self) {
+std::tuple<AST::Function*, builtin::BuiltinFunc const*> Evaluator::findFunction(SymbolID name, Object* self) {
 
   for( auto&& bf : builtin::BuiltinFunc::getAllFunctions() ) {
     if( !bf.have_self != !self )
@@ -500,7 +658,7 @@ std::tuple<AST::Function const*, builtin::BuiltinFunc const*> Evaluator::findFun
     if( self && !self->type.equals(bf.self_type) )
       continue;
 
-    if( bf.name == name ) {
+    if( bf.sym == name ) {
       return { nullptr, &bf };
     }
   }
@@ -511,18 +669,55 @@ std::tuple<AST::Function const*, builtin::BuiltinFunc const*> Evaluator::findFun
 
     auto func = ast->as<AST::Function>();
 
-    if( func->getName() == name )
+    if( func->getSymbol() == name )
       return { func, nullptr };
   }
 
   return { nullptr, nullptr };
 }
 
-AST::Struct const* Evaluator::findStruct(std::string_view name) {
+//
+// -- findEnumerator() --
+//
+Enumerator* Evaluator::findEnumerator(AST::MemberAccess* ast) {
+  if( ast->resolved )
+    return ast->enumerator;
+
+  ast->resolved = true;
+
+  if( ast->left->kind != ASTKind::Variable || ast->right->kind != ASTKind::Variable )
+    return nullptr;
+
+  auto it = this->enums.find(ast->left->as<AST::Variable>()->getSymbol());
+
+  if( it == this->enums.end() )
+    return nullptr;
+
+  auto E = it->second;
+
+  if( E->values.empty() ) {
+    for( uint32_t i = 0; i < E->enumerators.size(); i++ )
+      E->values.emplace_back(new Enumerator(E, i));
+  }
+
+  auto name = ast->right->as<AST::Variable>();
+
+  for( size_t i = 0; i < E->enumerators.size(); i++ ) {
+    if( E->enumerators[i]->sym == name->getSymbol() )
+      return ast->enumerator = E->values[i];
+  }
+
+  Error(ast->right)
+    .setMessage("enum '" + std::string(E->getName()) + "' don't have a enumerator '" + std::string(name->getName()) + "'")
+    .emit()
+    .exit();
+}
+
+AST::Struct const* Evaluator::findStruct(SymbolID name) {
   for( auto&& ast : this->rootScope->list ) {
     alertmsg(ast->token->str);
 
-    if( ast->kind == ASTKind::Struct && ast->as<AST::Struct>()->getName() == name )
+    if( ast->kind == ASTKind::Struct && ast->as<AST::Struct>()->getSymbol() == name )
       return ast->as<AST::Struct>();
   }
 
@@ -31,6 +31,7 @@ namespace {
 bool _isEnabled;
 bool _isBusy;
 std::mutex mtx;
+std::mutex collectMtx;  // objects may be created by several threads
 std::thread* thread;
 size_t mark_count;
 
@@ -89,6 +90,12 @@ void _Mark(Object* object) {
 
       break;
     }
+
+    case TypeInfo::Lines:
+      if( auto file = object->as<Lines>()->file; file )
+        _Mark(file);
+
+      break;
   }
 }
 
@@ -136,6 +143,7 @@ void _CollectThreadFunc() {
 }
 
 void _Collect() {
+  std::lock_guard lock{ collectMtx };
 
   if( _isBusy )
     return;
@@ -164,6 +172,10 @@ bool isEnabled() {
   return _isEnabled;
 }
 
+size_t maxObjectCount() {
+  return OBJECT_MEMORY_MAXIMUM;
+}
+
 Object* _registerObject(Object* object) {
   if( !isEnabled() )
     return object;
@@ -0,0 +1,1012 @@
+#include <bit>
+#include <cmath>
+#include <charconv>
+#include <algorithm>
+#include <unordered_map>
+#include "AST.h"
+#include "GC.h"
+#include "JSON.h"
+
+#if defined(__x86_64__)
+  #include <immintrin.h>
+#endif
+
+namespace metro::json {
+
+using namespace objects;
+
+namespace {
+
+// max depth of nested arrays and objects
+constexpr size_t MaxDepth = 512;
+
+// objects with members at least this count use a hash map to find same keys
+constexpr size_t KeyMapThreshold = 16;
+
+constexpr uint64_t OddBits = 0xAAAAAAAAAAAAAAAAull;
+
+bool isSpace(char16_t c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isOperator(char16_t c) {
+  return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+}
+
+//
+// bits of characters in a block of 64 characters.
+//
+struct Block {
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t op;      // { } [ ] : ,
+  uint64_t space;
+};
+
+void classify(char16_t const* p, Block& block) {
+  block = { };
+
+  for( int i = 0; i < 64; i++ ) {
+    uint64_t bit = 1ull << i;
+
+    if( p[i] == '"' )
+      block.quote |= bit;
+    else if( p[i] == '\\' )
+      block.backslash |= bit;
+    else if( isOperator(p[i]) )
+      block.op |= bit;
+    else if( isSpace(p[i]) )
+      block.space |= bit;
+  }
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+uint32_t movemask32(__m256i a, __m256i b) {
+  // 16-bit lanes --> 8-bit lanes, then fix the order of 128-bit lanes
+  auto packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0b11011000);
+
+  return (uint32_t)_mm256_movemask_epi8(packed);
+}
+
+__attribute__((target("avx2")))
+void classify_avx2(char16_t const* p, Block& block) {
+  auto const quote = _mm256_set1_epi16('"');
+  auto const backslash = _mm256_set1_epi16('\\');
+  auto const open = _mm256_set1_epi16('{');     // "[" | 0x20
+  auto const close = _mm256_set1_epi16('}');    // "]" | 0x20
+  auto const colon = _mm256_set1_epi16(':');
+  auto const comma = _mm256_set1_epi16(',');
+  auto const lower = _mm256_set1_epi16(0x20);
+  auto const space = _mm256_set1_epi16(' ');
+  auto const tab = _mm256_set1_epi16('\t');
+  auto const lf = _mm256_set1_epi16('\n');
+  auto const cr = _mm256_set1_epi16('\r');
+
+  block = { };
+
+  for( int i = 0; i < 64; i += 32 ) {
+    __m256i q[2], bs[2], op[2], sp[2];
+
+    for( int j = 0; j < 2; j++ ) {
+      auto x = _mm256_loadu_si256((__m256i const*)(p + i + j * 16));
+      auto xl = _mm256_or_si256(x, lower);
+
+      q[j] = _mm256_cmpeq_epi16(x, quote);
+      bs[j] = _mm256_cmpeq_epi16(x, backslash);
+
+      op[j] = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi16(xl, open), _mm256_cmpeq_epi16(xl, close)),
+        _mm256_or_si256(_mm256_cmpeq_epi16(x, colon), _mm256_cmpeq_epi16(x, comma)));
+
+      sp[j] = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi16(x, space), _mm256_cmpeq_epi16(x, tab)),
+        _mm256_or_si256(_mm256_cmpeq_epi16(x, lf), _mm256_cmpeq_epi16(x, cr)));
+    }
+
+    block.quote |= (uint64_t)movemask32(q[0], q[1]) << i;
+    block.backslash |= (uint64_t)movemask32(bs[0], bs[1]) << i;
+    block.op |= (uint64_t)movemask32(op[0], op[1]) << i;
+    block.space |= (uint64_t)movemask32(sp[0], sp[1]) << i;
+  }
+}
+#endif
+
+// bit i = xor of bits 0 .. i
+uint64_t prefixXor(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+
+  return x;
+}
+
+//
+// Index
+//   stage 1: positions of the structural characters.
+//
+//   "{", "}", "[", "]", ":" and "," out of strings, the opening quote of
+//   each string, and the first character of each other value (number,
+//   true, false, null) are indexed. so every value starts at an index,
+//   and a string or a primitive value takes one index.
+//
+struct Index {
+  std::vector<uint32_t> positions;
+
+  // for "{" and "[", the index of the matching bracket
+  std::vector<uint32_t> pairs;
+
+  bool build(std::u16string_view text, std::string& error) {
+    this->positions.clear();
+
+    if( text.length() >= UINT32_MAX ) {
+      error = "text is too large";
+      return false;
+    }
+
+#if defined(__x86_64__)
+    static bool const hasAVX2 = __builtin_cpu_supports("avx2");
+    auto classifyBlock = hasAVX2 ? classify_avx2 : classify;
+#else
+    auto classifyBlock = classify;
+#endif
+
+    // states carried to the next block
+    uint64_t nextIsEscaped = 0;
+    uint64_t prevInString = 0;    // all ones if in string
+    uint64_t prevScalar = 0;
+
+    for( size_t base = 0; base < text.length(); base += 64 ) {
+      Block block;
+
+      if( text.length() - base >= 64 )
+        classifyBlock(text.data() + base, block);
+      else {
+        char16_t buf[64];
+
+        std::fill(std::copy(text.begin() + base, text.end(), buf), buf + 64, u' ');
+        classify(buf, block);
+      }
+
+      //
+      // escaped characters: after an odd count of backslashes.
+      // adding the starts of runs of backslashes carries to the end of the runs,
+      // and the parity is told by the position (odd or even) of the end.
+      //
+      uint64_t escaped;
+
+      if( block.backslash == 0 ) {
+        escaped = nextIsEscaped;
+        nextIsEscaped = 0;
+      }
+      else {
+        uint64_t potential = block.backslash & ~nextIsEscaped;
+        uint64_t codes = (((potential << 1) | OddBits) - potential) ^ OddBits;
+
+        escaped = codes ^ (block.backslash | nextIsEscaped);
+        nextIsEscaped = (codes & block.backslash) >> 63;
+      }
+
+      uint64_t quote = block.quote & ~escaped;
+
+      // from the opening quote to the last character of each string
+      uint64_t inString = prefixXor(quote) ^ prevInString;
+
+      prevInString = (uint64_t)((int64_t)inString >> 63);
+
+      // characters of the other values
+      uint64_t scalar = ~(block.op | block.space | block.quote) & ~inString;
+      uint64_t scalarStart = scalar & ~((scalar << 1) | prevScalar);
+
+      prevScalar = scalar >> 63;
+
+      // padding
+      if( text.length() - base < 64 )
+        scalarStart &= (1ull << (text.length() - base)) - 1;
+
+      for( auto bits = (block.op & ~inString) | (quote & inString) | scalarStart; bits; bits &= bits - 1 )
+        this->positions.emplace_back(base + std::countr_zero(bits));
+    }
+
+    // the last index is the opening quote
+    if( prevInString ) {
+      error = "unterminated string at " + std::to_string(this->positions.back());
+      return false;
+    }
+
+    return this->matchBrackets(text, error);
+  }
+
+  bool matchBrackets(std::u16string_view text, std::string& error) {
+    std::vector<uint32_t> stack;
+
+    this->pairs.resize(std::max(this->pairs.size(), this->positions.size()));
+
+    for( uint32_t i = 0; i < this->positions.size(); i++ ) {
+      auto pos = this->positions[i];
+
+      switch( text[pos] ) {
+        case '{':
+        case '[':
+          if( stack.size() >= MaxDepth ) {
+            error = "too deep nesting at " + std::to_string(pos);
+            return false;
+          }
+
+          stack.emplace_back(i);
+          break;
+
+        case '}':
+        case ']':
+          if( stack.empty() || text[this->positions[stack.back()]] != (text[pos] == '}' ? '{' : '[') ) {
+            error = "unmatched '" + std::string(1, (char)text[pos]) + "' at " + std::to_string(pos);
+            return false;
+          }
+
+          this->pairs[stack.back()] = i;
+          stack.pop_back();
+          break;
+      }
+    }
+
+    if( !stack.empty() ) {
+      error = "unclosed '" + std::string(1, (char)text[this->positions[stack.back()]])
+        + "' at " + std::to_string(this->positions[stack.back()]);
+
+      return false;
+    }
+
+    return true;
+  }
+};
+
+//
+// Builder
+//   stage 2: build objects by walking the index.
+//
+//   a container is stored to its slot in the parent before its elements
+//   are built, so all of the objects built are reachable from the root,
+//   and the root is bound to GC while building.
+//
+class Builder {
+public:
+  Builder(std::u16string_view text, Index const& index, std::string& error)
+    : text(text),
+      index(index),
+      error(error),
+      cur(0)
+  {
+  }
+
+  Object* parse() {
+    Object* ret = None::getNone();
+
+    if( this->index.positions.empty() ) {
+      this->fail("empty text", this->text.length());
+      return nullptr;
+    }
+
+    if( !this->parseValue(ret) ) {
+      this->release(ret);
+      return nullptr;
+    }
+
+    if( this->cur < this->index.positions.size() ) {
+      this->unexpected();
+      this->release(ret);
+      return nullptr;
+    }
+
+    this->release(ret);
+
+    return ret;
+  }
+
+  //
+  // find the value at "pointer" on the index, and build only it.
+  //
+  Object* parse(std::u16string_view pointer) {
+    Object* ret = None::getNone();
+
+    if( this->index.positions.empty() ) {
+      this->fail("empty text", this->text.length());
+      return nullptr;
+    }
+
+    // only one value in the text
+    if( this->skipValue(); this->cur < this->index.positions.size() ) {
+      this->unexpected();
+      return nullptr;
+    }
+
+    this->cur = 0;
+
+    if( !pointer.empty() && pointer[0] != '/' ) {
+      this->error = "invalid json pointer";
+      return nullptr;
+    }
+
+    while( !pointer.empty() ) {
+      auto end = std::min(pointer.find(u'/', 1), pointer.length());
+      auto found = this->findChild(unescapePointer(pointer.substr(1, end - 1)));
+
+      if( !found )
+        return nullptr;
+
+      pointer.remove_prefix(end);
+    }
+
+    if( !this->parseValue(ret) ) {
+      this->release(ret);
+      return nullptr;
+    }
+
+    this->release(ret);
+
+    return ret;
+  }
+
+private:
+  std::u16string_view text;
+  Index const& index;
+  std::string& error;
+
+  size_t cur;   // current index
+  bool bound = false;
+
+  bool fail(std::string const& msg, size_t pos) {
+    if( this->error.empty() )
+      this->error = msg + " at " + std::to_string(pos);
+
+    return false;
+  }
+
+  bool unexpected() {
+    if( this->cur >= this->index.positions.size() )
+      return this->fail("unexpected end", this->text.length());
+
+    auto pos = this->index.positions[this->cur];
+    auto c = this->text[pos];
+
+    if( c < 0x20 || c >= 0x7F )
+      return this->fail("unexpected character", pos);
+
+    return this->fail("unexpected '" + std::string(1, (char)c) + "'", pos);
+  }
+
+  // the character at the current index, or 0 at the end
+  char16_t peek() const {
+    if( this->cur >= this->index.positions.size() )
+      return 0;
+
+    return this->text[this->index.positions[this->cur]];
+  }
+
+  bool expect(char16_t c) {
+    if( this->peek() != c )
+      return this->unexpected();
+
+    this->cur++;
+    return true;
+  }
+
+  void bindRoot(Object* obj) {
+    if( !this->bound ) {
+      GC::bind(obj);
+      this->bound = true;
+    }
+  }
+
+  void release(Object* root) {
+    if( this->bound )
+      GC::unbind(root);
+
+    this->bound = false;
+  }
+
+  bool parseValue(Object*& slot) {
+    switch( this->peek() ) {
+      case '{':
+        return this->parseObject(slot);
+
+      case '[':
+        return this->parseArray(slot);
+
+      case '"': {
+        std::u16string str;
+
+        if( !this->parseString(str) )
+          return false;
+
+        slot = new String(std::move(str));
+        return true;
+      }
+
+      case 0:
+      case '}':
+      case ']':
+      case ':':
+      case ',':
+        return this->unexpected();
+    }
+
+    return this->parsePrimitive(slot);
+  }
+
+  bool parseObject(Object*& slot) {
+    auto dict = new Dict;
+
+    slot = dict;
+    this->bindRoot(dict);
+    this->cur++;
+
+    if( this->peek() == '}' ) {
+      this->cur++;
+      return true;
+    }
+
+    auto& elems = dict->elements;
+    std::unordered_map<std::u16string_view, size_t> keys;
+
+    while( true ) {
+      std::u16string key;
+
+      if( this->peek() != '"' )
+        return this->unexpected();
+
+      if( !this->parseString(key) || !this->expect(':') )
+        return false;
+
+      // the last one is used if the same key appears again
+      size_t i = 0;
+
+      if( elems.size() < KeyMapThreshold ) {
+        while( i < elems.size() && elems[i].first->as<String>()->value != key )
+          i++;
+      }
+      else {
+        if( keys.empty() ) {
+          for( size_t j = 0; j < elems.size(); j++ )
+            keys.emplace(elems[j].first->as<String>()->value, j);
+        }
+
+        auto it = keys.find(key);
+
+        i = it == keys.end() ? elems.size() : it->second;
+      }
+
+      if( i == elems.size() ) {
+        elems.emplace_back(new String(std::move(key)), None::getNone());
+
+        if( !keys.empty() )
+          keys.emplace(elems.back().first->as<String>()->value, i);
+      }
+
+      if( !this->parseValue(elems[i].second) )
+        return false;
+
+      if( this->peek() == ',' ) {
+        this->cur++;
+        continue;
+      }
+
+      return this->expect('}');
+    }
+  }
+
+  bool parseArray(Object*& slot) {
+    auto vec = new Vector;
+
+    slot = vec;
+    this->bindRoot(vec);
+    this->cur++;
+
+    if( this->peek() == ']' ) {
+      this->cur++;
+      return true;
+    }
+
+    while( true ) {
+      if( !this->parseValue(vec->elements.emplace_back(None::getNone())) )
+        return false;
+
+      if( this->peek() == ',' ) {
+        this->cur++;
+        continue;
+      }
+
+      return this->expect(']');
+    }
+  }
+
+  // the string at the current index
+  bool parseString(std::u16string& out) {
+    auto pos = this->index.positions[this->cur++] + 1;
+
+    while( true ) {
+      auto begin = pos;
+
+      while( pos < this->text.length() && this->text[pos] != '"' && this->text[pos] != '\\'
+        && this->text[pos] >= 0x20 )
+        pos++;
+
+      out.append(this->text.substr(begin, pos - begin));
+
+      if( pos >= this->text.length() )
+        return this->fail("unterminated string", pos);
+
+      if( this->text[pos] == '"' )
+        return true;
+
+      if( this->text[pos] < 0x20 )
+        return this->fail("control character in string", pos);
+
+      if( pos + 1 >= this->text.length() )
+        return this->fail("invalid escape", pos);
+
+      switch( this->text[pos + 1] ) {
+        case '"':   out += u'"';  break;
+        case '\\':  out += u'\\'; break;
+        case '/':   out += u'/';  break;
+        case 'b':   out += u'\b'; break;
+        case 'f':   out += u'\f'; break;
+        case 'n':   out += u'\n'; break;
+        case 'r':   out += u'\r'; break;
+        case 't':   out += u'\t'; break;
+
+        // a code unit of UTF-16, same as a character of string
+        case 'u': {
+          char16_t c = 0;
+
+          for( size_t i = pos + 2; i < pos + 6; i++ ) {
+            auto d = i < this->text.length() ? this->text[i] : 0;
+
+            if( d >= '0' && d <= '9' )
+              c = c * 16 + (d - '0');
+            else if( (d | 0x20) >= 'a' && (d | 0x20) <= 'f' )
+              c = c * 16 + ((d | 0x20) - 'a' + 10);
+            else
+              return this->fail("invalid escape", pos);
+          }
+
+          out += c;
+          pos += 4;
+          break;
+        }
+
+        default:
+          return this->fail("invalid escape", pos);
+      }
+
+      pos += 2;
+    }
+  }
+
+  bool parsePrimitive(Object*& slot) {
+    auto begin = this->index.positions[this->cur++];
+    auto end = begin;
+
+    while( end < this->text.length() && !isSpace(this->text[end]) && !isOperator(this->text[end])
+      && this->text[end] != '"' )
+      end++;
+
+    auto token = this->text.substr(begin, end - begin);
+
+    if( token == u"true" || token == u"false" ) {
+      slot = new Bool(token == u"true");
+      return true;
+    }
+
+    if( token == u"null" ) {
+      slot = None::getNone();
+      return true;
+    }
+
+    return this->parseNumber(token, begin, slot);
+  }
+
+  // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+  bool parseNumber(std::u16string_view token, size_t pos, Object*& slot) {
+    auto digits = [&] (size_t i) {
+      auto begin = i;
+
+      while( i < token.length() && token[i] >= '0' && token[i] <= '9' )
+        i++;
+
+      return i - begin;
+    };
+
+    size_t i = token.starts_with(u'-');
+    bool isInt = true;
+
+    if( auto n = digits(i); n == 0 || (n > 1 && token[i] == '0') )
+      return this->fail("invalid value", pos);
+    else
+      i += n;
+
+    if( i < token.length() && token[i] == '.' ) {
+      if( auto n = digits(++i); n == 0 )
+        return this->fail("invalid number", pos);
+      else
+        i += n;
+
+      isInt = false;
+    }
+
+    if( i < token.length() && (token[i] | 0x20) == 'e' ) {
+      if( ++i < token.length() && (token[i] == '+' || token[i] == '-') )
+        i++;
+
+      if( auto n = digits(i); n == 0 )
+        return this->fail("invalid number", pos);
+      else
+        i += n;
+
+      isInt = false;
+    }
+
+    if( i != token.length() )
+      return this->fail("invalid number", pos);
+
+    // all ASCII here
+    std::string str(token.begin(), token.end());
+
+    if( isInt ) {
+      int64_t value;
+
+      if( std::from_chars(str.data(), str.data() + str.length(), value).ec == std::errc{ } ) {
+        slot = new Int(value);
+        return true;
+      }
+    }
+
+    double value;
+
+    if( std::from_chars(str.data(), str.data() + str.length(), value).ec != std::errc{ } )
+      return this->fail("number out of range", pos);
+
+    slot = new Float(value);
+    return true;
+  }
+
+  // skip the value at the current index
+  void skipValue() {
+    switch( this->peek() ) {
+      case '{':
+      case '[':
+        this->cur = this->index.pairs[this->cur] + 1;
+        break;
+
+      default:
+        this->cur++;
+    }
+  }
+
+  //
+  // move to the member or the element "name" of the current value.
+  // returns false if not found or not a container.
+  //
+  bool findChild(std::u16string const& name) {
+    switch( this->peek() ) {
+      case '{': {
+        auto end = this->index.pairs[this->cur];
+        bool found = false;
+        size_t at = 0;
+
+        // the last one of same keys
+        for( this->cur++; this->cur < end; ) {
+          std::u16string key;
+
+          if( this->peek() != '"' || !this->parseString(key) || !this->expect(':') )
+            return this->unexpected();
+
+          if( key == name ) {
+            found = true;
+            at = this->cur;
+          }
+
+          this->skipValue();
+
+          if( this->peek() == ',' )
+            this->cur++;
+        }
+
+        this->cur = at;
+
+        return found;
+      }
+
+      case '[': {
+        auto end = this->index.pairs[this->cur];
+        size_t n = 0;
+
+        if( name.empty() || name.length() > 9 || (name.length() > 1 && name[0] == '0') )
+          return false;
+
+        for( auto c : name ) {
+          if( c < '0' || c > '9' )
+            return false;
+
+          n = n * 10 + (c - '0');
+        }
+
+        for( this->cur++; n > 0 && this->cur < end; n-- ) {
+          this->skipValue();
+
+          if( this->peek() == ',' )
+            this->cur++;
+        }
+
+        return this->cur < end;
+      }
+    }
+
+    return false;
+  }
+
+  // "~1" --> "/", "~0" --> "~"
+  static std::u16string unescapePointer(std::u16string_view token) {
+    std::u16string ret;
+
+    for( size_t i = 0; i < token.length(); i++ ) {
+      if( token[i] == '~' && i + 1 < token.length() && (token[i + 1] == '0' || token[i + 1] == '1') )
+        ret += token[++i] == '0' ? u'~' : u'/';
+      else
+        ret += token[i];
+    }
+
+    return ret;
+  }
+};
+
+//
+// Writer
+//   append the JSON text of objects to a string.
+//
+class Writer {
+public:
+  Writer(std::u16string& out, std::string& error)
+    : out(out),
+      error(error),
+      depth(0)
+  {
+  }
+
+  bool write(Object const* obj) {
+    switch( obj->type.kind ) {
+      case TypeInfo::None:
+        this->out.append(u"null");
+        return true;
+
+      case TypeInfo::Bool:
+        this->out.append(obj->as<Bool>()->value ? u"true" : u"false");
+        return true;
+
+      case TypeInfo::Int:
+        return this->writeNumber(obj->as<Int>()->value);
+
+      case TypeInfo::USize:
+        return this->writeNumber(obj->as<USize>()->value);
+
+      case TypeInfo::Float:
+        return this->writeNumber(obj->as<Float>()->value);
+
+      case TypeInfo::Char:
+        this->writeString(std::u16string_view(&obj->as<Char>()->value, 1));
+        return true;
+
+      case TypeInfo::String:
+        this->writeString(obj->as<String>()->value);
+        return true;
+
+      case TypeInfo::StringBuilder:
+        this->writeString(obj->as<StringBuilder>()->value);
+        return true;
+
+      case TypeInfo::Vector:
+        return this->writeArray(obj->as<Vector>()->elements);
+
+      case TypeInfo::Tuple:
+        return this->writeArray(obj->as<Tuple>()->elements);
+
+      case TypeInfo::Dict:
+      case TypeInfo::Struct:
+        return this->writeObject(obj);
+    }
+
+    this->error = "cannot convert " + obj->type.to_string() + " to json";
+    return false;
+  }
+
+private:
+  std::u16string& out;
+  std::string& error;
+  size_t depth;
+
+  template <class T>
+  bool writeNumber(T value) {
+    char buf[32];
+    auto end = std::to_chars(buf, buf + sizeof(buf), value).ptr;
+
+    if constexpr( std::is_floating_point_v<T> ) {
+      if( !std::isfinite(value) ) {
+        this->error = "cannot convert " + std::string(buf, end) + " to json";
+        return false;
+      }
+
+      this->out.append(buf, end);
+
+      // keep it a float when parsed again
+      if( std::find_if(buf, end, [] (char c) { return c == '.' || c == 'e'; }) == end )
+        this->out.append(u".0");
+
+      return true;
+    }
+
+    this->out.append(buf, end);
+    return true;
+  }
+
+  void writeString(std::u16string_view str) {
+    static constexpr char digits[] = "0123456789abcdef";
+
+    this->out += u'"';
+
+    for( size_t i = 0; i < str.length(); ) {
+      auto begin = i;
+
+      while( i < str.length() && str[i] >= 0x20 && str[i] != '"' && str[i] != '\\' )
+        i++;
+
+      this->out.append(str.substr(begin, i - begin));
+
+      if( i == str.length() )
+        break;
+
+      switch( auto c = str[i++] ) {
+        case '"':   this->out.append(u"\\\""); break;
+        case '\\':  this->out.append(u"\\\\"); break;
+        case '\b':  this->out.append(u"\\b"); break;
+        case '\f':  this->out.append(u"\\f"); break;
+        case '\n':  this->out.append(u"\\n"); break;
+        case '\r':  this->out.append(u"\\r"); break;
+        case '\t':  this->out.append(u"\\t"); break;
+
+        default:
+          this->out.append(u"\\u00");
+          this->out += (char16_t)digits[c >> 4];
+          this->out += (char16_t)digits[c & 15];
+      }
+    }
+
+    this->out += u'"';
+  }
+
+  bool enter() {
+    if( ++this->depth > MaxDepth ) {
+      this->error = "too deep nesting (or cyclic)";
+      return false;
+    }
+
+    return true;
+  }
+
+  bool writeArray(std::vector<Object*> const& elems) {
+    if( !this->enter() )
+      return false;
+
+    this->out += u'[';
+
+    for( size_t i = 0; i < elems.size(); i++ ) {
+      if( i != 0 )
+        this->out += u',';
+
+      if( !this->write(elems[i]) )
+        return false;
+    }
+
+    this->out += u']';
+    this->depth--;
+
+    return true;
+  }
+
+  bool writeObject(Object const* obj) {
+    if( !this->enter() )
+      return false;
+
+    this->out += u'{';
+
+    if( obj->type.kind == TypeInfo::Struct ) {
+      auto& elems = obj->as<Vector>()->elements;
+      auto ast = obj->type.ast_struct;
+
+      for( size_t i = 0; i < elems.size(); i++ ) {
+        if( i != 0 )
+          this->out += u',';
+
+        this->writeString(utils::decode_utf8(ast->members[i]->str));
+        this->out += u':';
+
+        if( !this->write(elems[i]) )
+          return false;
+      }
+    }
+    else for( bool first = true; auto&& [k, v] : obj->as<Dict>()->elements ) {
+      if( !first )
+        this->out += u',';
+
+      switch( k->type.kind ) {
+        case TypeInfo::String:
+          this->writeString(k->as<String>()->value);
+          break;
+
+        case TypeInfo::Char:
+          this->writeString(std::u16string_view(&k->as<Char>()->value, 1));
+          break;
+
+        default:
+          this->error = "key of json object must be string, but got " + k->type.to_string();
+          return false;
+      }
+
+      this->out += u':';
+
+      if( !this->write(v) )
+        return false;
+
+      first = false;
+    }
+
+    this->out += u'}';
+    this->depth--;
+
+    return true;
+  }
+};
+
+//
+// the index of the current thread.
+// reused by every parse, so that the pages of the buffers are not
+// allocated again for each large text.
+//
+Index& getIndex() {
+  thread_local Index index;
+
+  return index;
+}
+
+} // namespace
+
+Object* parse(std::u16string_view text, std::string& error) {
+  auto& index = getIndex();
+
+  error.clear();
+
+  if( !index.build(text, error) )
+    return nullptr;
+
+  return Builder(text, index, error).parse();
+}
+
+Object* parse(std::u16string_view text, std::u16string_view pointer, std::string& error) {
+  auto& index = getIndex();
+
+  error.clear();
+
+  if( !index.build(text, error) )
+    return nullptr;
+
+  return Builder(text, index, error).parse(pointer);
+}
+
+bool stringify(std::u16string& out, Object const* obj, std::string& error) {
+  error.clear();
+
+  return Writer(out, error).write(obj);
+}
+
+} // namespace metro::json
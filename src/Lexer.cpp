@@ -1,49 +1,68 @@
+#include <array>
+#include <charconv>
 #include "SourceLoc.h"
 #include "Error.h"
 #include "Lexer.h"
 
 namespace metro {
 
-static char const* punctuaters[] {
-  "<<=",
-  ">>=",
-  "->",
-  "<<",
-  ">>",
-  "<=",
-  ">=",
-  "==",
-  "!=",
-  "..",
-  "&&",
-  "||",
-  "<",
-  ">",
-  "+",
-  "-",
-  "/",
-  "*",
-  "%",
-  "=",
-  ";",
-  ":",
-  ",",
-  ".",
-  "[",
-  "]",
-  "(",
-  ")",
-  "{",
-  "}",
-  "!",
-  "?",
-  "&",
-  "^",
-  "|",
+namespace {
+
+//
+// class of characters.
+//
+enum CharClass : uint8_t {
+  CC_Space  = 1 << 0,   // ' ' \t \n \v \f \r
+  CC_Digit  = 1 << 1,   // 0-9
+  CC_Hex    = 1 << 2,   // 0-9 a-f A-F
+  CC_Bin    = 1 << 3,   // 0 1
+  CC_Alpha  = 1 << 4,   // a-z A-Z _
+
+  CC_Ident  = CC_Alpha | CC_Digit,
 };
 
-Lexer::Lexer(SourceLoc const& src)
+constexpr auto charClassTable = [] {
+  std::array<uint8_t, 256> table { };
+
+  for( int c = 0; c < 256; c++ ) {
+    if( c == ' ' || (c >= '\t' && c <= '\r') )
+      table[c] |= CC_Space;
+
+    if( c >= '0' && c <= '9' )
+      table[c] |= CC_Digit | CC_Hex;
+
+    if( c == '0' || c == '1' )
+      table[c] |= CC_Bin;
+
+    if( (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') )
+      table[c] |= CC_Hex;
+
+    if( (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' )
+      table[c] |= CC_Alpha;
+  }
+
+  return table;
+}();
+
+bool isClass(char c, uint8_t mask) {
+  return charClassTable[(uint8_t)c] & mask;
+}
+
+size_t getPunctuaterLength(SymbolID sym) {
+  if( sym <= Sym::ShiftRightAssign )
+    return 3;
+
+  if( sym <= Sym::LogOR )
+    return 2;
+
+  return 1;
+}
+
+} // anonymous namespace
+
+Lexer::Lexer(SourceLoc const& src, ConstantPool& constants)
   : loc(src),
+    constants(constants),
     source(src.data),
     position(0)
 {
@@ -53,137 +72,335 @@ Lexer::~Lexer()
 {
 }
 
-Token* Lexer::lex() {
-  Token top;
-  Token* cur = &top;
+TokenList Lexer::lex() {
+  TokenList tokens;
+
+  auto append = [&] (TokenKind kind, size_t pos) -> Token& {
+    return tokens.emplace_back(kind, this->source.substr(pos, this->position - pos), pos, &this->loc);
+  };
+
+  tokens.reserve(this->source.length() / 4);
 
   this->pass_space();
 
   while( this->check() ) {
-    auto str = this->source.data() + this->position;
     auto pos = this->position;
     auto c = this->peek();
 
-    // hex
-    if( this->match("0x") ) {
-      this->position += 2;
-      cur = new Token(TokenKind::Binary, cur, { str, this->pass_while(isxdigit) }, pos);
-    }
+    // hex, bin
+    if( c == '0' && (this->peek(1) == 'x' || this->peek(1) == 'b') ) {
+      auto isHex = this->peek(1) == 'x';
 
-    // bin
-    else if( this->match("0b") ) {
       this->position += 2;
-      cur = new Token(TokenKind::Binary, cur, { str,
-        this->pass_while([] (char x) { return x == '0' || x == '1'; }) }, pos);
+
+      if( !this->pass_while(isHex ? CC_Hex : CC_Bin) )
+        this->error(pos, isHex ? "invalid hexadecimal literal" : "invalid binary literal");
+
+      auto& tok = append(isHex ? TokenKind::Hexadecimal : TokenKind::Binary, pos);
+
+      // all 64 bits can be used. (0xFFFFFFFFFFFFFFFF == -1)
+      auto value = this->decode_integer<uint64_t>(tok.str.substr(2), isHex ? 16 : 2, pos);
+
+      tok.constIndex = this->add_constant(new objects::Int((int64_t)value));
     }
 
     // digits
-    else if( isdigit(c) ) {
-      cur = new Token(TokenKind::Int, cur, { str, this->pass_while(isdigit) }, pos);
+    else if( isClass(c, CC_Digit) ) {
+      this->pass_while(CC_Digit);
 
+      // usize
       if( this->peek() == 'u' ) {
-        cur->kind = TokenKind::USize;
+        auto& tok = append(TokenKind::USize, pos);
         this->position++;
+
+        tok.constIndex = this->add_constant(
+          new objects::USize(this->decode_integer<uint64_t>(tok.str, 10, pos)));
       }
-      else if( this->peek() == '.' ) {
+
+      // float
+      else if( this->peek() == '.' && isClass(this->peek(1), CC_Digit) ) {
         this->position++;
+        this->pass_while(CC_Digit);
+
+        auto& tok = append(TokenKind::Float, pos);
+
+        tok.constIndex = this->add_constant(new objects::Float(this->decode_float(tok.str, pos)));
+      }
 
-        this->pass_while(isdigit);
+      else {
+        auto& tok = append(TokenKind::Int, pos);
 
-        cur->kind = TokenKind::Float;
-        cur->str = { str, this->position - pos };
+        tok.constIndex = this->add_constant(
+          new objects::Int(this->decode_integer<int64_t>(tok.str, 10, pos)));
       }
     }
 
-    // identifier
-    else if( isalpha(c) || c == '_' ) {
-      cur = new Token(TokenKind::Identifier, cur, { str,
-        this->pass_while([] (char x) { return isalnum(x) || x == '_'; }) }, pos);
+    // identifier, keyword
+    else if( isClass(c, CC_Alpha) ) {
+      this->pass_while(CC_Ident);
+
+      auto& tok = append(TokenKind::Identifier, pos);
+
+      tok.sym = SymbolTable::get(tok.str);
+
+      if( SymbolTable::isKeyword(tok.sym) )
+        tok.kind = TokenKind::Keyword;
     }
 
     // char
     else if( c == '\'' ) {
-      cur = new Token(TokenKind::Char, cur, this->eat_literal(c), pos + 1);
+      if( !this->eat_literal(c) )
+        this->error(pos, "unterminated character literal");
+
+      auto& tok = tokens.emplace_back(TokenKind::Char,
+        this->source.substr(pos + 1, this->position - pos - 2), pos + 1, &this->loc);
+
+      auto str = this->decode_string(tok.str, pos);
+
+      if( str.length() != 1 )
+        this->error(pos, "character literal must be one character");
+
+      tok.constIndex = this->add_constant(new objects::Char(str[0]));
     }
 
     // string
     else if( c == '"' ) {
-      cur = new Token(TokenKind::String, cur, this->eat_literal(c), pos + 1);
-    }
-
-    // find punctuater
-    else {
-      for( std::string_view pu : punctuaters ) {
-        if( this->match(pu) ) {
-          cur = new Token(TokenKind::Punctuater, cur, pu, pos);
-          this->position += pu.length();
-          goto found_punctuater;
-        }
-      }
+      if( !this->eat_literal(c) )
+        this->error(pos, "unterminated string literal");
 
-      cur = new Token(TokenKind::Unknown, nullptr, " ", pos);
-      cur->position = pos;
-      cur->source = &this->loc;
+      auto& tok = tokens.emplace_back(TokenKind::String,
+        this->source.substr(pos + 1, this->position - pos - 2), pos + 1, &this->loc);
 
-      Error(cur)
-        .setMessage("unknown token")
-        .emit()
-        .exit();
+      tok.constIndex = this->add_constant(new objects::String(this->decode_string(tok.str, pos)));
+    }
 
-    found_punctuater:;
+    // punctuater
+    else if( auto sym = this->match_punctuater(); sym ) {
+      this->position += getPunctuaterLength(sym);
+      append(TokenKind::Punctuater, pos).sym = sym;
     }
 
+    else
+      this->error(pos, "unknown token");
+
     this->pass_space();
   }
 
-  for( auto p = top.next; p; p = p->next )
-    p->source = &this->loc;
+  tokens.emplace_back(TokenKind::End, "", this->position, &this->loc);
 
-  cur = new Token(TokenKind::End, cur, "", this->position);
-  cur->source = &this->loc;
+  return tokens;
+}
 
-  auto ret = top.next;
+bool Lexer::check() {
+  return this->position < this->source.length();
+}
 
-  top.next = nullptr;
+char Lexer::peek(size_t offset) {
+  if( this->position + offset < this->source.length() )
+    return this->source[this->position + offset];
 
-  return ret;
+  return 0;
 }
 
-bool Lexer::check() {
-  return this->position < this->source.length();
+size_t Lexer::pass_space() {
+  return this->pass_while(CC_Space);
+}
+
+size_t Lexer::pass_while(uint8_t charClass) {
+  auto begin = this->source.data() + this->position;
+  auto end = this->source.data() + this->source.length();
+  auto p = begin;
+
+  while( p < end && isClass(*p, charClass) )
+    p++;
+
+  this->position += p - begin;
+
+  return p - begin;
 }
 
-char Lexer::peek() {
-  return this->source[this->position];
+//
+// match_punctuater:
+//   the longest punctuater at current position.
+//   Sym::None if not found.
+//
+SymbolID Lexer::match_punctuater() {
+  auto c1 = this->peek(1);
+
+  switch( this->peek() ) {
+    case '<':
+      if( c1 == '<' )
+        return this->peek(2) == '=' ? Sym::ShiftLeftAssign : Sym::ShiftLeft;
+
+      return c1 == '=' ? Sym::LessOrEqual : Sym::Less;
+
+    case '>':
+      if( c1 == '>' )
+        return this->peek(2) == '=' ? Sym::ShiftRightAssign : Sym::ShiftRight;
+
+      return c1 == '=' ? Sym::BiggerOrEqual : Sym::Bigger;
+
+    case '-': return c1 == '>' ? Sym::Arrow : Sym::Minus;
+    case '=': return c1 == '=' ? Sym::Equal : Sym::Assign;
+    case '!': return c1 == '=' ? Sym::NotEqual : Sym::Exclamation;
+    case '.': return c1 == '.' ? Sym::DoubleDot : Sym::Dot;
+    case '&': return c1 == '&' ? Sym::LogAND : Sym::Ampersand;
+    case '|': return c1 == '|' ? Sym::LogOR : Sym::VerticalBar;
+
+    case '+': return Sym::Plus;
+    case '/': return Sym::Slash;
+    case '*': return Sym::Star;
+    case '%': return Sym::Percent;
+    case ';': return Sym::Semicolon;
+    case ':': return Sym::Colon;
+    case ',': return Sym::Comma;
+    case '[': return Sym::BracketOpen;
+    case ']': return Sym::BracketClose;
+    case '(': return Sym::ParenOpen;
+    case ')': return Sym::ParenClose;
+    case '{': return Sym::BraceOpen;
+    case '}': return Sym::BraceClose;
+    case '?': return Sym::Question;
+    case '^': return Sym::Caret;
+  }
+
+  return Sym::None;
 }
 
-bool Lexer::match(std::string_view s) {
-  if( this->position + s.length() <= this->source.length() )
-    return this->source.substr(this->position, s.length()) == s;
+//
+// eat_literal:
+//   pass the literal enclosed with "quat".
+//   returns false if not closed.
+//
+bool Lexer::eat_literal(char quat) {
+  for( auto i = this->position + 1; i < this->source.length(); i++ ) {
+    // escape sequence
+    if( this->source[i] == '\\' )
+      i++;
+    else if( this->source[i] == quat ) {
+      this->position = i + 1;
+      return true;
+    }
+  }
 
   return false;
 }
 
-size_t Lexer::pass_space() {
-  return this->pass_while(isspace);
+template <class T>
+T Lexer::decode_integer(std::string_view str, int base, size_t pos) {
+  T value { };
+
+  auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.length(), value, base);
+
+  if( ec == std::errc::result_out_of_range )
+    this->error(pos, "integer literal is too large");
+
+  return value;
 }
 
-size_t Lexer::pass_while(std::function<bool(char)> cond) {
-  size_t count = 0;
+double Lexer::decode_float(std::string_view str, size_t pos) {
+  double value { };
+
+  auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.length(), value);
 
-  while( cond(this->peek()) )
-    count++, this->position++;
+  if( ec == std::errc::result_out_of_range )
+    this->error(pos, "floating-point literal is out of range");
 
-  return count;
+  return value;
 }
 
-std::string_view Lexer::eat_literal(char quat) {
-  auto pos = ++this->position;
+//
+// decode_string:
+//   UTF-8 with escape sequences --> UTF-16.
+//
+std::u16string Lexer::decode_string(std::string_view str, size_t pos) {
+  std::u16string ret;
+
+  ret.reserve(str.length());
+
+  auto p = str.begin();
+  auto end = str.end();
+
+  // the number of hex digits
+  auto hexDigits = [&] (size_t count) -> char32_t {
+    char32_t cp = 0;
+
+    for( size_t i = 0; i < count; i++ ) {
+      if( p == end || !isClass(*p, CC_Hex) )
+        this->error(pos, "invalid escape sequence");
+
+      auto c = *p++;
+
+      cp = cp * 16 + (isClass(c, CC_Digit) ? c - '0' : (c | 0x20) - 'a' + 10);
+    }
+
+    return cp;
+  };
+
+  while( p != end ) {
+    char32_t cp = (uint8_t)*p++;
+
+    // escape sequence
+    if( cp == '\\' ) {
+      switch( *p++ ) {
+        case 'n':  cp = '\n'; break;
+        case 't':  cp = '\t'; break;
+        case 'r':  cp = '\r'; break;
+        case '0':  cp = '\0'; break;
+        case '\\': cp = '\\'; break;
+        case '\'': cp = '\''; break;
+        case '"':  cp = '"'; break;
+
+        case 'x':  cp = hexDigits(2); break;
+        case 'u':  cp = hexDigits(4); break;
+
+        default:
+          this->error(pos, "invalid escape sequence");
+      }
+    }
+
+    // UTF-8 multi-byte sequence
+    else if( cp >= 0x80 ) {
+      size_t count = cp >= 0xF0 ? 3 : cp >= 0xE0 ? 2 : 1;
+
+      cp &= 0x3F >> count;
+
+      for( size_t i = 0; i < count; i++ ) {
+        if( p == end || (*p & 0xC0) != 0x80 )
+          this->error(pos, "invalid UTF-8 sequence");
+
+        cp = (cp << 6) | (*p++ & 0x3F);
+      }
+    }
+
+    // surrogate pair
+    if( cp >= 0x10000 ) {
+      cp -= 0x10000;
+      ret += (char16_t)(0xD800 + (cp >> 10));
+      ret += (char16_t)(0xDC00 + (cp & 0x3FF));
+    }
+    else
+      ret += (char16_t)cp;
+  }
+
+  return ret;
+}
+
+uint32_t Lexer::add_constant(objects::Object* obj) {
+  obj->noDelete = true;
+
+  this->constants.emplace_back(obj);
+
+  return (uint32_t)(this->constants.size() - 1);
+}
 
-  while( this->peek() != quat )
-    this->position++;
+void Lexer::error(size_t pos, std::string const& msg) {
+  Token tok{ TokenKind::Unknown, this->source.substr(pos, 1), pos, &this->loc };
 
-  return { this->source.data() + pos, (this->position++) - pos };
+  Error(&tok)
+    .setMessage(msg)
+    .emit()
+    .exit();
 }
 
-} // namespace metro
\ No newline at end of file
+} // namespace metro
@@ -1,33 +1,84 @@
 #include <iostream>
 #include <cstdlib>
+#include <filesystem>
+#include <unordered_set>
 
 #include "Metro.h"
 #include "Color.h"
 #include "SourceLoc.h"
 #include "Error.h"
+#include "Output.h"
 
 #include "Lexer.h"
 #include "Parser.h"
 #include "Evaluator.h"
 #include "GC.h"
+#include "Utils.h"
+#include "ScriptCache.h"
 
 static constexpr auto helpMessage = R"xyz(
-Metro v0.0.1
+Metro v)xyz" METRO_VERSION R"xyz(
 (C) Aoki & all members of the team metrolanguage
 
 usage: metro [options] [script files...]
 
 options:
   -h --help     show this info
+  --no-cache    don't read or write compiled cache (*.metroc)
+  --eager-parse parse all functions before running (reports all syntax errors)
+  --line-buffered
+                flush the output at each newline even if not a terminal
 )xyz";
 
 namespace metro {
 
 static Metro* g_instance;
 
+namespace {
+
+struct ImportInfo {
+  std::string path;
+  Token* token;
+};
+
+//
+// find "import a/b;" in tokens.
+// malformed imports are skipped here and reported by the parser.
+//
+std::vector<ImportInfo> findImports(TokenList& tokens) {
+  std::vector<ImportInfo> ret;
+
+  for( auto tok = tokens.data(); tok->kind != TokenKind::End; tok++ ) {
+    if( tok->sym != Sym::Import )
+      continue;
+
+    auto begin = tok;
+    std::string path;
+
+    while( (++tok)->kind == TokenKind::Identifier ) {
+      path += tok->str;
+
+      if( (++tok)->sym != Sym::Slash )
+        break;
+
+      path += '/';
+    }
+
+    if( tok->sym == Sym::Semicolon && !path.ends_with('/') )
+      ret.emplace_back(path + ".metro", begin);
+
+    if( tok->kind == TokenKind::End )
+      break;
+  }
+
+  return ret;
+}
+
+} // anonymous namespace
+
 Metro::ScriptInfo::ScriptInfo(std::string const& path)
   : source(path),
-    token(nullptr),
+    hash(0),
     ast(nullptr),
     result(nullptr)
 {
@@ -36,15 +87,13 @@ Metro::ScriptInfo::ScriptInfo(std::string const& path)
 Metro::ScriptInfo::~ScriptInfo()
 {
   delete this->result;
-  delete this->ast;
-  delete this->token;
-
-  for( auto&& S : this->_imported )
-    delete S;
 }
 
 Metro::Metro(int argc, char** argv)
-  : currentScript(nullptr)
+  : currentScript(nullptr),
+    currentEvaluator(nullptr),
+    useCache(true),
+    eagerParse(false)
 {
   g_instance = this;
   
@@ -58,8 +107,6 @@ Metro::~Metro()
 
 int Metro::main() {
 
-  srand((unsigned)time(nullptr));
-
   GC::initialize();
 
   this->parseArguments();
@@ -82,9 +129,18 @@ Metro::ScriptInfo* Metro::getRunningScript() {
   return this->currentScript;
 }
 
+Evaluator* Metro::getEvaluator() {
+  return this->currentEvaluator;
+}
+
 void Metro::fatalError(std::string const& msg) {
+  // may be called by the thread of GC, while the main thread is running
+  Output::flushAll();
+
   std::cout << Color::Red << "fatal error: " << Color::Default << msg << std::endl;
-  std::exit(1);
+
+  // without destroying static objects which the other threads are using
+  std::_Exit(1);
 }
 
 Metro* Metro::getInstance() {
@@ -94,23 +150,151 @@ Metro* Metro::getInstance() {
 void Metro::evaluateScript(Metro::ScriptInfo& script) {
   this->currentScript = &script;
 
-  Lexer lexer{ script.source };
+  this->loadScript(script);
+
+  Error::check();
+
+  this->linkImports(script);
+
+  Evaluator eval{ script.ast->as<AST::Scope>() };
+
+  this->currentEvaluator = &eval;
+
+  eval.eval(script.ast);
+
+  this->currentEvaluator = nullptr;
+
+  GC::doCollectForce();
+}
+
+void Metro::loadScript(Metro::ScriptInfo& script) {
+  std::vector<ScriptInfo*> loaded;
+  std::vector<ScriptInfo*> pending{ &script };
+
+  // the script itself can be imported by its modules
+  this->moduleCache.emplace(std::filesystem::weakly_canonical(script.source.path).string(), &script);
+
+  //
+  // find the import graph level by level,
+  // lex the modules of each level in parallel.
+  //
+  while( !pending.empty() ) {
+    std::vector<std::vector<ImportInfo>> imports(pending.size());
+
+    utils::parallel_for(pending.size(), [&] (size_t i) {
+      auto S = pending[i];
 
-  script.token = lexer.lex();
+      S->hash = utils::hash(S->source.data);
+
+      Error::Defer defer;
+
+      try {
+        // the cache may have functions not parsed yet
+        if( !this->useCache || this->eagerParse || !cache::load(*S) )
+          S->tokens = Lexer(S->source, S->constants).lex();
+
+        imports[i] = findImports(S->tokens);
+      }
+      catch( Error::Aborted const& ) {
+        // the error is already emitted
+      }
+    });
+
+    Error::check();
+
+    loaded.insert(loaded.end(), pending.begin(), pending.end());
+
+    std::vector<ScriptInfo*> next;
+
+    for( size_t i = 0; i < pending.size(); i++ ) {
+      for( auto&& imp : imports[i] ) {
+        if( !std::filesystem::is_regular_file(imp.path) ) {
+          Error(imp.token)
+            .setMessage("cannot open file '" + imp.path + "'")
+            .emit()
+            .exit();
+        }
+
+        auto [module, isNew] = this->getModule(imp.path);
+
+        pending[i]->_imported.emplace_back(module);
+
+        if( isNew )
+          next.emplace_back(module);
+      }
+    }
+
+    pending = std::move(next);
+  }
 
   Error::check();
 
-  Parser parser{ script.token };
+  //
+  // modules are independent of each other until linked,
+  // so parse all of them in parallel.
+  //
+  utils::parallel_for(loaded.size(), [&] (size_t i) {
+    auto S = loaded[i];
 
-  script.ast = parser.parse();
+    // loaded from the cache
+    if( S->ast )
+      return;
+
+    Error::Defer defer;
+
+    try {
+      S->ast = Parser(S->tokens, S->constants, S->arena, this->eagerParse).parse();
+    }
+    catch( Error::Aborted const& ) {
+      return;
+    }
+
+    if( this->useCache )
+      cache::save(*S);
+  });
 
   Error::check();
+}
 
-  Evaluator eval{ script.ast->as<AST::Scope>() };
+std::pair<Metro::ScriptInfo*, bool> Metro::getModule(std::string const& path) {
+  auto key = std::filesystem::weakly_canonical(path).string();
 
-  eval.eval(script.ast);
+  if( auto it = this->moduleCache.find(key); it != this->moduleCache.end() )
+    return { it->second, false };
 
-  GC::doCollectForce();
+  auto module = &this->modules.emplace_back(path);
+
+  this->moduleCache.emplace(key, module);
+
+  return { module, true };
+}
+
+void Metro::linkImports(Metro::ScriptInfo& script) {
+  if( script._imported.empty() )
+    return;
+
+  auto& list = script.ast->as<AST::Scope>()->list;
+
+  AST::List<AST::Base*> linked{ list.get_allocator() };
+  std::unordered_set<ScriptInfo*> visited{ &script };
+
+  auto link = [&] (auto&& self, ScriptInfo* S) -> void {
+    if( !visited.emplace(S).second )
+      return;
+
+    for( auto&& M : S->_imported )
+      self(self, M);
+
+    for( auto&& ast : S->ast->as<AST::Scope>()->list )
+      linked.emplace_back(ast);
+  };
+
+  for( auto&& M : script._imported )
+    link(link, M);
+
+  linked.insert(linked.end(), list.begin(), list.end());
+
+  list = std::move(linked);
 }
 
 void Metro::parseArguments() {
@@ -121,6 +305,15 @@ void Metro::parseArguments() {
       std::cout << helpMessage << std::endl;
       std::exit(1);
     }
+    else if( arg == "--no-cache" ) {
+      this->useCache = false;
+    }
+    else if( arg == "--eager-parse" ) {
+      this->eagerParse = true;
+    }
+    else if( arg == "--line-buffered" ) {
+      Output::setStdoutMode(Output::Mode::Line);
+    }
     else {
       this->scripts.emplace_back(arg);
     }
@@ -1,15 +1,20 @@
 #include <cassert>
+#include <cmath>
+#include <cstring>
 #include <map>
+#include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
 #include "alert.h"
 #include "GC.h"
 #include "AST.h"
+#include "Output.h"
 
 namespace metro::objects {
 
-None None::_none;
-
 debug(
   std::map<Object*, bool> __dbg_map;
+  std::mutex __dbg_mtx;
 
   struct XX {
     ~XX() {
@@ -24,6 +29,9 @@ debug(
   static XX _xx;
 )
 
+// after the map of debug, since its destructor uses the map
+None None::_none;
+
 Object::Object(TypeInfo type)
   : type(std::move(type)),
     isMarked(false),
@@ -32,16 +40,20 @@ Object::Object(TypeInfo type)
   GC::_registerObject(this);
 
   debug(
-    if( GC::isEnabled() )
+    if( GC::isEnabled() ) {
+      std::lock_guard lock{ __dbg_mtx };
       __dbg_map[this] = 1;
+    }
   )
 }
 
 Object::~Object()
 {
   debug(
-    if( GC::isEnabled() )
+    if( GC::isEnabled() ) {
+      std::lock_guard lock{ __dbg_mtx };
       __dbg_map[this] = 0;
+    }
   )
 }
 
@@ -60,6 +72,13 @@ bool Object::equals(Object* object) const {
 #define __CASE__(T) \
   case TypeInfo::T: return this->as<T>()->equals(object->as<T>());
 
+  // enumerator: compare the immediates
+  if( this->type.kind == TypeInfo::Enumerator ) {
+    return
+      object->type.kind == TypeInfo::Enumerator
+        && this->as<Enumerator>()->equals(object->as<Enumerator>());
+  }
+
   if( !this->type.equals(object->type) )
     return false;
 
@@ -74,6 +93,11 @@ bool Object::equals(Object* object) const {
     __CASE__(Dict)
     __CASE__(Tuple)
     __CASE__(Range)
+    __CASE__(Bytes)
+    __CASE__(StringBuilder)
+    __CASE__(Regex)
+    __CASE__(File)
+    __CASE__(Lines)
   }
 
   assert(this->type.equals(TypeInfo::None));
@@ -81,97 +105,197 @@ bool Object::equals(Object* object) const {
   return true;
 }
 
-std::string _Primitive<std::u16string, TypeInfo::String>::to_string() const {
-  std::u16string s;
+template <class T>
+static int compareValue(T const& a, T const& b) {
+  return a < b ? -1 : b < a;
+}
+
+// NaN is greater than any other number
+static int compareFloat(double a, double b) {
+  if( std::isnan(a) || std::isnan(b) )
+    return std::isnan(a) - std::isnan(b);
 
-  for( auto&& c : this->value )
-    s += c->value;
-  
-  return conv.to_bytes(s);
+  return compareValue(a, b);
 }
 
-String* _Primitive<std::u16string, TypeInfo::String>::clone() const {
-  return new String(this->value);
+static int compareNumber(Object const* a, Object const* b) {
+  auto ka = a->type.kind;
+  auto kb = b->type.kind;
+
+  if( ka == TypeInfo::Float || kb == TypeInfo::Float ) {
+    auto toFloat = [] (Object const* x) -> double {
+      switch( x->type.kind ) {
+        case TypeInfo::Int:   return (double)x->as<Int>()->value;
+        case TypeInfo::USize: return (double)x->as<USize>()->value;
+      }
+
+      return x->as<Float>()->value;
+    };
+
+    return compareFloat(toFloat(a), toFloat(b));
+  }
+
+  if( ka == TypeInfo::Int && kb == TypeInfo::Int )
+    return compareValue(a->as<Int>()->value, b->as<Int>()->value);
+
+  if( ka == TypeInfo::USize && kb == TypeInfo::USize )
+    return compareValue(a->as<USize>()->value, b->as<USize>()->value);
+
+  // int and usize
+  if( ka == TypeInfo::Int )
+    return a->as<Int>()->value < 0 ? -1 : compareValue((uint64_t)a->as<Int>()->value, (uint64_t)b->as<USize>()->value);
+
+  return -compareNumber(b, a);
 }
 
-bool String::equals(String* str) const {
-  if( this->value.size() != str->value.size() )
-    return false;
+static int compareElements(std::vector<Object*> const& a, std::vector<Object*> const& b) {
+  for( size_t i = 0; i < a.size() && i < b.size(); i++ )
+    if( auto c = a[i]->compare(b[i]); c != 0 )
+      return c;
 
-  for( auto it = this->value.begin(); auto&& c : str->value )
-    if( !(*it++)->equals(c) )
-      return false;
+  return compareValue(a.size(), b.size());
+}
 
-  return true;
+int Object::compare(Object const* object) const {
+  if( this->isNumeric() && object->isNumeric() )
+    return compareNumber(this, object);
+
+  if( this->type.kind != object->type.kind )
+    return compareValue(this->type.kind, object->type.kind);
+
+  switch( this->type.kind ) {
+    case TypeInfo::Bool:
+      return compareValue(this->as<Bool>()->value, object->as<Bool>()->value);
+
+    case TypeInfo::Char:
+      return compareValue(this->as<Char>()->value, object->as<Char>()->value);
+
+    case TypeInfo::String:
+      return this->as<String>()->value.compare(object->as<String>()->value);
+
+    case TypeInfo::StringBuilder:
+      return this->as<StringBuilder>()->value.compare(object->as<StringBuilder>()->value);
+
+    case TypeInfo::Regex:
+      return this->as<Regex>()->pattern.compare(object->as<Regex>()->pattern);
+
+    case TypeInfo::Vector:
+    case TypeInfo::Struct:
+      return compareElements(this->as<Vector>()->elements, object->as<Vector>()->elements);
+
+    case TypeInfo::Tuple:
+      return compareElements(this->as<Tuple>()->elements, object->as<Tuple>()->elements);
+
+    case TypeInfo::Pair:
+      if( auto c = this->as<Pair>()->first->compare(object->as<Pair>()->first); c != 0 )
+        return c;
+
+      return this->as<Pair>()->second->compare(object->as<Pair>()->second);
+
+    case TypeInfo::Range:
+      if( auto c = compareValue(this->as<Range>()->begin, object->as<Range>()->begin); c != 0 )
+        return c;
+
+      return compareValue(this->as<Range>()->end, object->as<Range>()->end);
+
+    case TypeInfo::Enumerator:
+      return compareValue(this->as<Enumerator>()->getKey(), object->as<Enumerator>()->getKey());
+
+    case TypeInfo::Bytes:
+      return this->as<Bytes>()->compare(object->as<Bytes>());
+  }
+
+  return 0;
 }
 
-_Primitive<std::u16string, TypeInfo::String>::_Primitive(std::u16string const& str)
-  : Object(TypeInfo::String)
-{
-  for( auto&& c : str )
-    this->value.emplace_back(new Char(c));
+std::string _Primitive<std::u16string, TypeInfo::String>::to_string() const {
+  return Output::toString(this);
 }
 
-_Primitive<std::u16string, TypeInfo::String>::_Primitive(std::string const& str)
-  : _Primitive(conv.from_bytes(str))
-{
+String* _Primitive<std::u16string, TypeInfo::String>::clone() const {
+  return new String(this->value);
 }
 
-_Primitive<std::u16string, TypeInfo::String>::_Primitive(std::vector<Char*> val)
+bool String::equals(String* str) const {
+  return this->value == str->value;
+}
+
+_Primitive<std::u16string, TypeInfo::String>::_Primitive(std::u16string val)
   : Object(TypeInfo::String),
     value(std::move(val))
 {
 }
 
+_Primitive<std::u16string, TypeInfo::String>::_Primitive(std::string_view str)
+  : _Primitive(utils::decode_utf8(str))
+{
+}
+
 String* String::append(Char* ch) {
-  this->value.emplace_back(ch);
+  this->value += ch->value;
   return this;
 }
 
 String* String::append(String* str) {
-  for( auto&& c : str->value )
-    this->append(c->clone());
-
+  this->value += str->value;
   return this;
 }
 
-std::string Vector::to_string() const {
-  if( this->elements.empty() )
-    return "[]";
-  
-  std::string ret;
-
-  auto isStruct = this->type.kind == TypeInfo::Struct;
-
-  for( size_t i = 0; i < this->elements.size(); i++ ) {
-    auto& e = this->elements[i];
-
-    if( isStruct )
-      ret += std::string(this->type.ast_struct->members[i]->str) + ": ";
-
-    ret += e->to_string();
-
-    if( e != *this->elements.rbegin() )
-      ret += ", ";
-  }
+int64_t Enumerator::getKey() const {
+  return ((int64_t)this->getEnum()->id << 32) | this->index;
+}
 
-  if( isStruct )
-    return this->type.ast_struct->getName() + "{" + ret + "}";
+std::string Enumerator::to_string() const {
+  return std::string(this->getEnum()->getName()) + "." + std::string(this->getEnum()->enumerators[this->index]->str);
+}
 
-  return '[' + ret + ']';
+std::string Vector::to_string() const {
+  return Output::toString(this);
 }
 
+//
+// the clone is bound to GC while cloning the elements, since GC may run
+// while creating them.
+//
 Vector* Vector::clone() const {
   auto vec = new Vector();
 
   vec->type = this->type;
 
+  if( this->elements.empty() )
+    return vec;
+
+  GC::bind(vec);
+  vec->elements.reserve(this->elements.size());
+
   for( auto&& e : this->elements )
     vec->append(e->clone());
 
+  GC::unbind(vec);
+
   return vec;
 }
 
+Dict* Dict::clone() const {
+  auto dict = new Dict();
+
+  if( this->elements.empty() )
+    return dict;
+
+  GC::bind(dict);
+  dict->elements.reserve(this->elements.size());
+
+  for( auto&& [k, v] : this->elements ) {
+    auto& elem = dict->append(k->clone(), None::getNone());
+
+    elem.second = v->clone();
+  }
+
+  GC::unbind(dict);
+
+  return dict;
+}
+
 bool Vector::equals(Vector* vec) const {
   if( this->elements.size() != vec->elements.size() )
     return false;
@@ -188,9 +312,9 @@ bool Vector::equals(Vector* vec) const {
   *   find the member with name
   *   only can use in TypeInfo::Struct
   */
-Object** Vector::getMember(std::string const& name) {
+Object** Vector::getMember(SymbolID name) {
   for( size_t i = 0; auto&& m : this->type.ast_struct->members ) {
-    if( m->str == name )
+    if( m->sym == name )
       return &this->elements[i];
 
     i++;
@@ -199,4 +323,150 @@ Object** Vector::getMember(std::string const& name) {
   return nullptr;
 }
 
+std::string Bytes::to_string() const {
+  return Output::toString(this);
+}
+
+uint64_t Bytes::readInt(size_t offset, size_t size, bool bigEndian) const {
+  uint64_t ret = 0;
+
+  for( size_t i = 0; i < size; i++ )
+    ret |= (uint64_t)this->get()[offset + i] << ((bigEndian ? size - 1 - i : i) * 8);
+
+  return ret;
+}
+
+void Bytes::writeInt(size_t offset, size_t size, bool bigEndian, uint64_t value) {
+  auto& buf = this->getMutable();
+
+  for( size_t i = 0; i < size; i++ )
+    buf[offset + i] = (uint8_t)(value >> ((bigEndian ? size - 1 - i : i) * 8));
+}
+
+int64_t Bytes::find(Bytes const* needle, size_t begin) const {
+  auto& hay = this->get();
+  auto& pat = needle->get();
+
+  if( begin > hay.size() || pat.size() > hay.size() - begin )
+    return -1;
+
+  if( pat.empty() )
+    return begin;
+
+  auto p = hay.data() + begin;
+  auto last = hay.data() + hay.size() - pat.size();
+
+  // find the first byte by memchr, and compare the rest
+  while( p <= last ) {
+    p = (uint8_t const*)std::memchr(p, pat[0], last - p + 1);
+
+    if( !p )
+      break;
+
+    if( std::memcmp(p + 1, pat.data() + 1, pat.size() - 1) == 0 )
+      return p - hay.data();
+
+    p++;
+  }
+
+  return -1;
+}
+
+int Bytes::compare(Bytes const* bytes) const {
+  auto& a = this->get();
+  auto& b = bytes->get();
+
+  auto len = std::min(a.size(), b.size());
+  auto ret = len ? std::memcmp(a.data(), b.data(), len) : 0;
+
+  if( ret == 0 )
+    return a.size() < b.size() ? -1 : a.size() > b.size();
+
+  return ret < 0 ? -1 : 1;
+}
+
+std::string StringBuilder::to_string() const {
+  return Output::toString(this);
+}
+
+std::string Regex::to_string() const {
+  return Output::toString(this);
+}
+
+StringBuilder* StringBuilder::append(Object const* obj) {
+  appendText(this->value, obj);
+
+  return this;
+}
+
+void StringBuilder::appendText(std::u16string& dest, Object const* obj) {
+  switch( obj->type.kind ) {
+    case TypeInfo::Char:
+      dest.push_back(obj->as<Char>()->value);
+      break;
+
+    case TypeInfo::String:
+      dest.append(obj->as<String>()->value);
+      break;
+
+    case TypeInfo::StringBuilder:
+      dest.append(obj->as<StringBuilder>()->value);
+      break;
+
+    default:
+      dest.append(utils::decode_utf8(Output::toString(obj)));
+      break;
+  }
+}
+
+bool File::open() {
+  static constexpr int flags[] {
+    O_RDONLY,                       // Read
+    O_WRONLY | O_CREAT | O_TRUNC,   // Write
+    O_WRONLY | O_CREAT | O_APPEND,  // Append
+  };
+
+  this->fd = ::open(this->path.c_str(), flags[(int)this->mode] | O_CLOEXEC, 0644);
+
+  if( this->fd < 0 )
+    return false;
+
+  if( this->mode != Mode::Read )
+    this->out = new Output(this->fd, Output::Mode::Full);
+
+  return true;
+}
+
+void File::close() {
+  if( !this->isOpen() )
+    return;
+
+  delete this->out;
+  this->out = nullptr;
+
+  ::close(this->fd);
+  this->fd = -1;
+}
+
+File::~File()
+{
+  this->close();
+}
+
+std::string Dict::to_string() const {
+  return Output::toString(this);
+}
+
+std::string Tuple::to_string() const {
+  return Output::toString(this);
+}
+
+std::string Pair::to_string() const {
+  return Output::toString(this);
+}
+
+std::string Range::to_string() const {
+  return Output::toString(this);
+}
+
 } // namespace metro::objects
\ No newline at end of file
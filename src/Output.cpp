@@ -0,0 +1,412 @@
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <unistd.h>
+#include "AST.h"
+#include "Object.h"
+#include "Output.h"
+
+namespace metro {
+
+using namespace objects;
+
+// -1 = not decided yet
+static std::atomic_int stdoutMode = -1;
+
+//
+// the stdout of all threads.
+// registered while the thread is alive, so that the buffers of the other
+// threads are not lost when exit(3) is called by a thread.
+//
+struct StdoutRegistry {
+  std::mutex mtx;
+  std::vector<Output*> outputs;
+
+  static StdoutRegistry& get() {
+    static StdoutRegistry registry;
+
+    return registry;
+  }
+};
+
+// the stdout of a thread
+struct ThreadStdout {
+  Output out;
+
+  ThreadStdout(Output::Mode mode)
+    : out(STDOUT_FILENO, mode)
+  {
+    auto& reg = StdoutRegistry::get();
+
+    // after the registry is constructed, so called before it is destroyed
+    static bool const atexitDone = (std::atexit(Output::flushAll), true);
+    (void)atexitDone;
+
+    std::lock_guard lock{ reg.mtx };
+
+    reg.outputs.emplace_back(&this->out);
+  }
+
+  ~ThreadStdout() {
+    auto& reg = StdoutRegistry::get();
+    std::lock_guard lock{ reg.mtx };
+
+    std::erase(reg.outputs, &this->out);
+  }
+};
+
+Output::Output(int fd, Mode mode)
+  : fd(fd),
+    dest(nullptr),
+    mode(mode),
+    count(0),
+    length(0),
+    needFlush(false)
+{
+}
+
+Output::Output(std::string& dest)
+  : Output(-1, Mode::Full)
+{
+  this->dest = &dest;
+}
+
+Output::~Output()
+{
+  this->flush();
+}
+
+Output& Output::write(std::string_view str) {
+  // too large to buffer
+  if( str.length() > BufferSize ) {
+    this->flush();
+
+    if( this->dest )
+      this->dest->append(str);
+    else for( auto p = str.data(), end = p + str.length(); p < end; ) {
+      auto n = ::write(this->fd, p, end - p);
+
+      if( n < 0 && errno != EINTR )
+        break;
+
+      if( n > 0 )
+        p += n;
+    }
+
+    this->count += str.length();
+
+    return *this;
+  }
+
+  auto p = this->reserve(str.length());
+
+  std::memcpy(p, str.data(), str.length());
+
+  if( this->mode == Mode::Line && std::memchr(p, '\n', str.length()) )
+    this->needFlush = true;
+
+  this->commit(p + str.length());
+
+  return *this;
+}
+
+Output& Output::write(std::u16string_view str) {
+  for( size_t i = 0; i < str.length(); i++ ) {
+    char32_t cp = str[i];
+
+    // surrogate pair
+    if( cp >= 0xD800 && cp <= 0xDBFF && i + 1 < str.length()
+      && str[i + 1] >= 0xDC00 && str[i + 1] <= 0xDFFF ) {
+      cp = 0x10000 + ((cp - 0xD800) << 10) + (str[++i] - 0xDC00);
+    }
+
+    this->putChar(cp);
+  }
+
+  return *this;
+}
+
+Output& Output::write(int64_t value) {
+  auto p = this->reserve(32);
+
+  this->commit(std::to_chars(p, p + 32, value).ptr);
+
+  return *this;
+}
+
+Output& Output::write(uint64_t value) {
+  auto p = this->reserve(32);
+
+  this->commit(std::to_chars(p, p + 32, value).ptr);
+
+  return *this;
+}
+
+Output& Output::write(double value) {
+  // "%f" of DBL_MAX takes 316 bytes
+  auto p = this->reserve(400);
+
+  this->commit(std::to_chars(p, p + 400, value, std::chars_format::fixed, 6).ptr);
+
+  return *this;
+}
+
+Output& Output::put(char c) {
+  auto p = this->reserve(1);
+
+  *p = c;
+
+  if( this->mode == Mode::Line && c == '\n' )
+    this->needFlush = true;
+
+  this->commit(p + 1);
+
+  return *this;
+}
+
+Output& Output::putChar(char32_t cp) {
+  if( cp < 0x80 )
+    return this->put((char)cp);
+
+  auto p = this->reserve(4);
+
+  if( cp < 0x800 ) {
+    *p++ = 0xC0 | (cp >> 6);
+  }
+  else if( cp < 0x10000 ) {
+    *p++ = 0xE0 | (cp >> 12);
+    *p++ = 0x80 | ((cp >> 6) & 0x3F);
+  }
+  else {
+    *p++ = 0xF0 | (cp >> 18);
+    *p++ = 0x80 | ((cp >> 12) & 0x3F);
+    *p++ = 0x80 | ((cp >> 6) & 0x3F);
+  }
+
+  *p++ = 0x80 | (cp & 0x3F);
+
+  this->commit(p);
+
+  return *this;
+}
+
+Output& Output::write(Object const* obj) {
+  switch( obj->type.kind ) {
+    case TypeInfo::None:
+      return this->write("none");
+
+    case TypeInfo::Int:
+      return this->write(obj->as<Int>()->value);
+
+    case TypeInfo::Float:
+      return this->write(obj->as<Float>()->value);
+
+    case TypeInfo::USize:
+      return this->write((uint64_t)obj->as<USize>()->value);
+
+    case TypeInfo::Bool:
+      return this->write(obj->as<Bool>()->value ? "true" : "false");
+
+    case TypeInfo::Char:
+      return this->putChar(obj->as<Char>()->value);
+
+    case TypeInfo::String:
+      return this->write(obj->as<String>()->value);
+
+    case TypeInfo::StringBuilder:
+      return this->write(obj->as<StringBuilder>()->value);
+
+    case TypeInfo::Regex:
+      return this->put('/').write(obj->as<Regex>()->pattern).put('/');
+
+    case TypeInfo::Enumerator: {
+      auto e = obj->as<Enumerator>();
+
+      return this->write(e->getEnum()->getName())
+        .put('.')
+        .write(e->getEnum()->enumerators[e->index]->str);
+    }
+
+    case TypeInfo::Range:
+      return this->write(obj->as<Range>()->begin)
+        .write(" .. ")
+        .write(obj->as<Range>()->end);
+
+    // bytes[00 01 ff]
+    case TypeInfo::Bytes: {
+      static constexpr char digits[] = "0123456789abcdef";
+
+      auto& bytes = obj->as<Bytes>()->get();
+
+      this->write("bytes[");
+
+      for( size_t i = 0; i < bytes.size(); i++ ) {
+        auto p = this->reserve(3);
+
+        if( i != 0 )
+          *p++ = ' ';
+
+        *p++ = digits[bytes[i] >> 4];
+        *p++ = digits[bytes[i] & 15];
+
+        this->commit(p);
+      }
+
+      return this->put(']');
+    }
+
+    case TypeInfo::Pair:
+      return this->write(obj->as<Pair>()->first)
+        .write(": ")
+        .write(obj->as<Pair>()->second);
+  }
+
+  // containers
+  char const* cycle =
+    obj->type.kind == TypeInfo::Dict ? "{...}" :
+    obj->type.kind == TypeInfo::Tuple ? "(...)" : "[...]";
+
+  if( std::find(this->active.begin(), this->active.end(), obj) != this->active.end() )
+    return this->write(cycle);
+
+  this->active.emplace_back(obj);
+
+  switch( obj->type.kind ) {
+    case TypeInfo::Vector: {
+      auto& elems = obj->as<Vector>()->elements;
+
+      this->put('[');
+      this->writeElements(elems.size(), [&] (size_t i) { this->write(elems[i]); });
+      this->put(']');
+
+      break;
+    }
+
+    case TypeInfo::Struct: {
+      auto& elems = obj->as<Vector>()->elements;
+      auto ast = obj->type.ast_struct;
+
+      this->write(ast->getName()).put('{');
+
+      this->writeElements(elems.size(), [&] (size_t i) {
+        this->write(ast->members[i]->str).write(": ").write(elems[i]);
+      });
+
+      this->put('}');
+
+      break;
+    }
+
+    case TypeInfo::Dict: {
+      auto& elems = obj->as<Dict>()->elements;
+
+      this->put('{');
+
+      this->writeElements(elems.size(), [&] (size_t i) {
+        this->write(elems[i].first).write(": ").write(elems[i].second);
+      });
+
+      this->put('}');
+
+      break;
+    }
+
+    case TypeInfo::Tuple: {
+      auto& elems = obj->as<Tuple>()->elements;
+
+      this->put('(');
+      this->writeElements(elems.size(), [&] (size_t i) { this->write(elems[i]); });
+      this->put(')');
+
+      break;
+    }
+
+    default:
+      this->write(obj->to_string());
+      break;
+  }
+
+  this->active.pop_back();
+
+  return *this;
+}
+
+std::string Output::toString(Object const* obj) {
+  std::string ret;
+
+  Output(ret).write(obj);
+
+  return ret;
+}
+
+void Output::flush() {
+  if( this->dest )
+    this->dest->append(this->buffer, this->length);
+  else for( size_t pos = 0; pos < this->length; ) {
+    auto n = ::write(this->fd, this->buffer + pos, this->length - pos);
+
+    if( n < 0 ) {
+      if( errno == EINTR )
+        continue;
+
+      break;
+    }
+
+    pos += n;
+  }
+
+  this->count += this->length;
+  this->length = 0;
+  this->needFlush = false;
+}
+
+Output& Output::getStdout() {
+  thread_local ThreadStdout local{
+    stdoutMode == -1
+      ? (::isatty(STDOUT_FILENO) ? Mode::Line : Mode::Full)
+      : (Mode)stdoutMode.load() };
+
+  return local.out;
+}
+
+void Output::flushAll() {
+  auto& reg = StdoutRegistry::get();
+  std::lock_guard lock{ reg.mtx };
+
+  for( auto&& out : reg.outputs )
+    out->flush();
+}
+
+void Output::setStdoutMode(Mode mode) {
+  stdoutMode = (int)mode;
+  getStdout().setMode(mode);
+}
+
+char* Output::reserve(size_t size) {
+  if( this->length + size > BufferSize )
+    this->flush();
+
+  return this->buffer + this->length;
+}
+
+template <class F>
+void Output::writeElements(size_t count, F&& writeAt) {
+  for( size_t i = 0; i < count; i++ ) {
+    if( i != 0 )
+      this->write(", ");
+
+    writeAt(i);
+  }
+}
+
+void Output::commit(char* end) {
+  this->length = end - this->buffer;
+
+  if( this->needFlush )
+    this->flush();
+}
+
+} // namespace metro
@@ -1,17 +1,104 @@
-#include <cassert>
+#include <array>
 #include "alert.h"
 #include "Error.h"
-#include "GC.h"
-#include "Lexer.h"
 #include "Parser.h"
-#include "SourceLoc.h"
-#include "Metro.h"
 
 namespace metro {
 
-Parser::Parser(Token* token)
-  : token(token),
-    ate(nullptr)
+namespace {
+
+//
+// Precedence of binary operators.
+// the greater binds the tighter.
+//
+enum Precedence : uint8_t {
+  Prec_None,
+  Prec_Assign,      // =
+  Prec_LogOR,       // ||
+  Prec_LogAND,      // &&
+  Prec_BitXOR,      // ^
+  Prec_BitOR,       // |
+  Prec_BitAND,      // &
+  Prec_Equality,    // == !=
+  Prec_Compare,     // > < >= <=
+  Prec_Pair,        // :
+  Prec_Range,       // ..
+  Prec_Shift,       // << >>
+  Prec_Add,         // + -
+  Prec_Mul,         // * / %
+};
+
+enum class Assoc : uint8_t {
+  Left,
+  Right,
+  None,
+};
+
+struct BinaryOperator {
+  ASTKind kind;
+  Precedence prec;
+  Assoc assoc;
+  bool swap;      // swap the operands:  "a < b" --> "b > a"
+  bool negate;    // wrap with Not:      "a != b" --> "!(a == b)"
+};
+
+constexpr auto binaryOperatorTable = [] {
+  std::array<BinaryOperator, Sym::_Identifiers> table { };
+
+  auto set = [&] (SymbolID sym, ASTKind kind, Precedence prec, Assoc assoc = Assoc::Left) -> BinaryOperator& {
+    return table[sym] = { kind, prec, assoc, false, false };
+  };
+
+  set(Sym::Star,          ASTKind::Mul,           Prec_Mul);
+  set(Sym::Slash,         ASTKind::Div,           Prec_Mul);
+  set(Sym::Percent,       ASTKind::Mod,           Prec_Mul);
+  set(Sym::Plus,          ASTKind::Add,           Prec_Add);
+  set(Sym::Minus,         ASTKind::Sub,           Prec_Add);
+  set(Sym::ShiftLeft,     ASTKind::LShift,        Prec_Shift);
+  set(Sym::ShiftRight,    ASTKind::RShift,        Prec_Shift);
+  set(Sym::DoubleDot,     ASTKind::Range,         Prec_Range, Assoc::None);
+  set(Sym::Colon,         ASTKind::Pair,          Prec_Pair, Assoc::None);
+  set(Sym::Bigger,        ASTKind::Bigger,        Prec_Compare);
+  set(Sym::Less,          ASTKind::Bigger,        Prec_Compare).swap = true;
+  set(Sym::BiggerOrEqual, ASTKind::BiggerOrEqual, Prec_Compare);
+  set(Sym::LessOrEqual,   ASTKind::BiggerOrEqual, Prec_Compare).swap = true;
+  set(Sym::Equal,         ASTKind::Equal,         Prec_Equality);
+  set(Sym::NotEqual,      ASTKind::Equal,         Prec_Equality).negate = true;
+  set(Sym::Ampersand,     ASTKind::BitAND,        Prec_BitAND);
+  set(Sym::VerticalBar,   ASTKind::BitOR,         Prec_BitOR);
+  set(Sym::Caret,         ASTKind::BitXOR,        Prec_BitXOR);
+  set(Sym::LogAND,        ASTKind::LogAND,        Prec_LogAND);
+  set(Sym::LogOR,         ASTKind::LogOR,         Prec_LogOR);
+  set(Sym::Assign,        ASTKind::Assignment,    Prec_Assign, Assoc::Right);
+
+  return table;
+}();
+
+BinaryOperator const* getBinaryOperator(Token const* tok) {
+  if( tok->kind != TokenKind::Punctuater )
+    return nullptr;
+
+  auto op = &binaryOperatorTable[tok->sym];
+
+  return op->prec != Prec_None ? op : nullptr;
+}
+
+} // anonymous namespace
+
+Parser::Parser(TokenList& tokens, ConstantPool const& constants, AST::Arena& arena,
+  bool isEager)
+  : Parser(tokens.data(), constants, arena, isEager)
+{
+}
+
+Parser::Parser(Token* begin, ConstantPool const& constants, AST::Arena& arena, bool isEager)
+  : constants(constants),
+    arena(arena),
+    begin(begin),
+    token(begin),
+    ate(nullptr),
+    loopDepth(0),
+    isEager(isEager)
 {
 }
 
@@ -19,42 +106,19 @@ Parser::Parser(Token* token)
  * parser
  */
 AST::Base* Parser::parse() {
-  auto ast = new AST::Scope(nullptr);
+  auto ast = this->arena.make<AST::Scope>(nullptr);
 
   while( this->check() ) {
     //
     // import
     //
-    if( this->eat("import") ) {
-      std::string path;
-      AST::Base* read = nullptr;
-
+    if( this->eat(Sym::Import) ) {
+      // the module itself is loaded by Metro::loadScript()
       do {
-        path += this->expectIdentifier()->str;
-      } while( this->eat("/") );
-
-      this->expect(";");
-
-      path += ".metro";
-
-      auto mt = Metro::getInstance();
-      auto curscript = mt->getRunningScript();
-
-      auto importedScript =
-        curscript->_imported.emplace_back(new Metro::ScriptInfo(path));
+        this->expectIdentifier();
+      } while( this->eat(Sym::Slash) );
 
-      auto save = curscript;
-
-      mt->currentScript = importedScript;
-
-      read = Parser(Lexer(importedScript->source).lex()).parse();
-
-      mt->currentScript = save;
-
-      assert(read->kind == ASTKind::Scope);
-
-      for( auto&& e : read->as<AST::Scope>()->list )
-        ast->list.emplace_back(e);
+      this->expect(Sym::Semicolon);
 
       continue;
     }
@@ -62,12 +126,12 @@ AST::Base* Parser::parse() {
     //
     // enum
     // 
-    if( this->eat("enum") ) {
-      auto x = new AST::Enum(this->ate, this->expectIdentifier());
+    if( this->eat(Sym::Enum) ) {
+      auto x = this->arena.make<AST::Enum>(this->ate, this->expectIdentifier());
 
-      this->expect("{");
+      this->expect(Sym::BraceOpen);
 
-      if( this->eat("}") ) {
+      if( this->eat(Sym::BraceClose) ) {
         Error(x->token)
           .setMessage("enum cannot be empty")
           .emit()
@@ -76,9 +140,9 @@ AST::Base* Parser::parse() {
 
       do {
         x->enumerators.emplace_back(this->expectIdentifier());
-      } while( this->eat(",") );
+      } while( this->eat(Sym::Comma) );
 
-      this->expect("}");
+      this->expect(Sym::BraceClose);
 
       ast->list.emplace_back(x);
       continue;
@@ -87,12 +151,12 @@ AST::Base* Parser::parse() {
     //
     // struct
     //
-    if( this->eat("struct") ) {
-      auto x = new AST::Struct(this->ate, this->expectIdentifier());
+    if( this->eat(Sym::Struct) ) {
+      auto x = this->arena.make<AST::Struct>(this->ate, this->expectIdentifier());
 
-      this->expect("{");
+      this->expect(Sym::BraceOpen);
 
-      if( this->eat("}") ) {
+      if( this->eat(Sym::BraceClose) ) {
         Error(x->token)
           .setMessage("struct cannot be empty")
           .emit()
@@ -101,9 +165,9 @@ AST::Base* Parser::parse() {
 
       do {
         x->members.emplace_back(this->expectIdentifier());
-      } while( this->eat(",") );
+      } while( this->eat(Sym::Comma) );
 
-      this->expect("}");
+      this->expect(Sym::BraceClose);
 
       ast->list.emplace_back(x);
       continue;
@@ -112,22 +176,27 @@ AST::Base* Parser::parse() {
     //
     // function definition
     //
-    if( this->eat("def") ) {
-      auto func = new AST::Function(this->ate);
+    if( this->eat(Sym::Def) ) {
+      auto func = this->arena.make<AST::Function>(this->ate);
 
       func->name_token = this->expectIdentifier();
       
-      this->expect("(");
+      this->expect(Sym::ParenOpen);
 
-      if( !this->eat(")") ) {
+      if( !this->eat(Sym::ParenClose) ) {
         do {
           func->arguments.emplace_back(this->expectIdentifier());
-        } while( this->eat(",") );
+        } while( this->eat(Sym::Comma) );
 
-        this->expect(")");
+        this->expect(Sym::ParenClose);
       }
 
-      func->scope = this->expectScope();
+      if( this->isEager )
+        func->scope = this->expectScope();
+      else {
+        func->body = this->skipScope();
+        func->constants = &this->constants;
+      }
 
       ast->list.emplace_back(func);
 
@@ -148,36 +217,38 @@ AST::Base* Parser::factor() {
 
   //
   // brackets
-  if( this->eat("(") ) {
+  if( this->eat(Sym::ParenOpen) ) {
     auto x = this->expr();
 
     //
     // tuple
-    if( this->eat(",") ) {
-      auto tuple = new AST::Array(tok, { x });
+    if( this->eat(Sym::Comma) ) {
+      auto tuple = this->arena.make<AST::Array>(tok);
+
+      tuple->elements.emplace_back(x);
 
       do {
         tuple->elements.emplace_back(this->expr());
-      } while( this->eat(",") );
+      } while( this->eat(Sym::Comma) );
 
       x = tuple;
     }
 
-    this->expect(")");
+    this->expect(Sym::ParenClose);
     return x;
   }
 
   //
   // array
-  if( this->eat("[") ) {
-    auto ast = new AST::Array(tok);
+  if( this->eat(Sym::BracketOpen) ) {
+    auto ast = this->arena.make<AST::Array>(tok);
 
-    if( !this->eat("]") ) {
+    if( !this->eat(Sym::BracketClose) ) {
       do {
         ast->elements.emplace_back(this->expr());
-      } while( this->eat(",") );
+      } while( this->eat(Sym::Comma) );
 
-      this->expect("]");
+      this->expect(Sym::BracketClose);
     }
 
     return ast;
@@ -186,53 +257,43 @@ AST::Base* Parser::factor() {
   //
   // boolean
   //
-  if( this->eat("true") )  return new AST::Value(tok, new objects::Bool(true));
-  if( this->eat("false") ) return new AST::Value(tok, new objects::Bool(false));
+  if( this->eat(Sym::True) )  return this->arena.make<AST::Value>(tok, new objects::Bool(true));
+  if( this->eat(Sym::False) ) return this->arena.make<AST::Value>(tok, new objects::Bool(false));
 
   //
   // immediate
   switch( tok->kind ) {
+    // decoded by lexer
+    case TokenKind::Hexadecimal:
+    case TokenKind::Binary:
     case TokenKind::Int:
-      this->next();
-      return new AST::Value(tok, new objects::Int(std::stoll(std::string(tok->str))));
-
     case TokenKind::Float:
-      this->next();
-      return new AST::Value(tok, new objects::Float(std::stof(std::string(tok->str))));
-
     case TokenKind::USize:
-      this->next();
-      return new AST::Value(tok, new objects::USize(std::stoull(std::string(tok->str))));
-
     case TokenKind::Char:
-      this->next();
-      return new AST::Value(tok,
-        new objects::Char(objects::String::conv.from_bytes(std::string(tok->str))[0]));
-
     case TokenKind::String:
       this->next();
-      return new AST::Value(tok, new objects::String(std::string(tok->str)));
+      return this->arena.make<AST::Value>(tok, this->constants[tok->constIndex]);
 
     case TokenKind::Identifier: {
       this->next();
 
       //
       // call func
-      if( this->eat("(") ) {
-        auto ast = new AST::CallFunc(tok);
+      if( this->eat(Sym::ParenOpen) ) {
+        auto ast = this->arena.make<AST::CallFunc>(tok);
         
-        if( !this->eat(")") ) {
+        if( !this->eat(Sym::ParenClose) ) {
           do {
             ast->arguments.emplace_back(this->expr());
-          } while( this->eat(",") );
+          } while( this->eat(Sym::Comma) );
 
-          this->expect(")");
+          this->expect(Sym::ParenClose);
         }
 
         return ast;
       }
 
-      return new AST::Variable(tok);
+      return this->arena.make<AST::Variable>(tok);
     }
   }
 
@@ -249,12 +310,12 @@ AST::Base* Parser::indexref() {
   auto x = this->factor();
 
   while( this->check() ) {
-    if( this->eat("[") ) {
-      x = new AST::Expr(ASTKind::IndexRef, this->ate, x, this->expr());
-      this->expect("]");
+    if( this->eat(Sym::BracketOpen) ) {
+      x = this->arena.make<AST::IndexRef>(this->ate, x, this->expr());
+      this->expect(Sym::BracketClose);
     }
-    else if( this->eat(".") ) {
-      x = new AST::Expr(ASTKind::MemberAccess, this->ate, x, this->factor());
+    else if( this->eat(Sym::Dot) ) {
+      x = this->arena.make<AST::MemberAccess>(this->ate, x, this->factor());
     }
     else
       break;
@@ -267,38 +328,37 @@ AST::Base* Parser::indexref() {
  * unary
  */
 AST::Base* Parser::unary() {
-  if( this->eat("-") )
-    return new AST::Expr(ASTKind::Sub, this->ate,
-      new AST::Value(nullptr, new objects::Int(0)), this->indexref());
+  if( this->eat(Sym::Minus) )
+    return this->arena.make<AST::Expr>(ASTKind::Sub, this->ate,
+      this->arena.make<AST::Value>(nullptr, new objects::Int(0)), this->indexref());
 
-  if( this->eat("!") )
-    return new AST::Expr(ASTKind::Not, this->ate, this->indexref(), nullptr);
+  if( this->eat(Sym::Exclamation) )
+    return this->arena.make<AST::Expr>(ASTKind::Not, this->ate, this->indexref(), nullptr);
 
-  if( this->eat("new") ) {
-    auto ast = new AST::CallFunc(this->ate);
+  if( this->eat(Sym::New) ) {
+    auto ast = this->arena.make<AST::CallFunc>(this->ate);
 
     ast->kind = ASTKind::New;
-    
-    ast->name =
-      (ast->nameToken = this->expectIdentifier())->str;
 
-    this->expect("{");
+    ast->setNameToken(this->expectIdentifier());
 
-    if( this->eat("}") ) {
+    this->expect(Sym::BraceOpen);
+
+    if( this->eat(Sym::BraceClose) ) {
       Error(this->ate)
         .setMessage("need at least one member").emit().exit();
     }
 
     do {
-      auto name = new AST::Variable(this->expectIdentifier());
+      auto name = this->arena.make<AST::Variable>(this->expectIdentifier());
 
-      auto colon = this->expect(":");
+      auto colon = this->expect(Sym::Colon);
       auto val = this->expr();
 
-      ast->arguments.emplace_back(new AST::Expr(ASTKind::Pair, colon, name, val));
-    } while( this->eat(",") );
+      ast->arguments.emplace_back(this->arena.make<AST::Expr>(ASTKind::Pair, colon, name, val));
+    } while( this->eat(Sym::Comma) );
 
-    this->expect("}");
+    this->expect(Sym::BraceClose);
 
     return ast;
   }
@@ -307,315 +367,231 @@ AST::Base* Parser::unary() {
 }
 
 /*
- * mul
+ * binary
+ *   parse binary operators whose precedence is "minPrec" or greater.
  */
-AST::Base* Parser::mul() {
+AST::Base* Parser::binary(int minPrec) {
   auto x = this->unary();
+  int maxPrec = Prec_Mul;
 
-  while( this->check() ) {
-    if( this->eat("*") )
-      x = new AST::Expr(ASTKind::Mul, this->ate, x, this->unary());
-    else if( this->eat("/") )
-      x = new AST::Expr(ASTKind::Div, this->ate, x, this->unary());
-    else if( this->eat("%") )
-      x = new AST::Expr(ASTKind::Mod, this->ate, x, this->unary());
-    else
+  while( auto op = getBinaryOperator(this->token) ) {
+    if( op->prec < minPrec || op->prec > maxPrec )
       break;
-  }
 
-  return x;
-}
+    auto tok = this->next();
+    auto y = this->binary(op->assoc == Assoc::Right ? op->prec : op->prec + 1);
 
-/*
- * add
- */
-AST::Base* Parser::add() {
-  auto x = this->mul();
+    if( op->swap )
+      std::swap(x, y);
 
-  while( this->check() ) {
-    if( this->eat("+") )
-      x = new AST::Expr(ASTKind::Add, this->ate, x, this->mul());
-    else if( this->eat("-") )
-      x = new AST::Expr(ASTKind::Sub, this->ate, x, this->mul());
-    else
-      break;
-  }
+    x = this->arena.make<AST::Expr>(op->kind, tok, x, y);
 
-  return x;
-}
+    if( op->negate )
+      x = this->arena.make<AST::Expr>(ASTKind::Not, tok, x, nullptr);
 
-/*
- * shift
- */
-AST::Base* Parser::shift() {
-  auto x = this->add();
-
-  while( this->check() ) {
-    if( this->eat("<<") )
-      x = new AST::Expr(ASTKind::LShift, this->ate, x, this->add());
-    else if( this->eat(">>") )
-      x = new AST::Expr(ASTKind::RShift, this->ate, x, this->add());
-    else
-      break;
+    // non-associative operator can't be chained
+    maxPrec = op->assoc == Assoc::None ? op->prec - 1 : op->prec;
   }
 
   return x;
 }
 
 /*
- * range
- */
-AST::Base* Parser::range() {
-  auto x = this->shift();
-
-  if( this->eat("..") )
-    return new AST::Expr(ASTKind::Range, this->ate, x, this->shift());
-
-  return x;
-}
-
-/*
- * pair
- */
-AST::Base* Parser::pair() {
-  auto x = this->range();
-
-  if( this->eat(":") )
-    return new AST::Expr(ASTKind::Pair, this->ate, x, this->range());
-
-  return x;
-}
-
-/*
- * compare
+ * expr
  */
-AST::Base* Parser::compare() {
-  auto x = this->pair();
-
-  while( this->check() ) {
-    if( this->eat(">") )
-      x = new AST::Expr(ASTKind::Bigger, this->ate, x, this->pair());
-    else if( this->eat("<") )
-      x = new AST::Expr(ASTKind::Bigger, this->ate, this->pair(), x);
-    else if( this->eat(">=") )
-      x = new AST::Expr(ASTKind::BiggerOrEqual, this->ate, x, this->pair());
-    else if( this->eat("<=") )
-      x = new AST::Expr(ASTKind::BiggerOrEqual, this->ate, this->pair(), x);
-    else
-      break;
-  }
-  
-  return x;
+AST::Base* Parser::expr() {
+  return this->binary(Prec_Assign);
 }
 
 /*
- * equality
+ * stmt
  */
-AST::Base* Parser::equality() {
-  auto x = this->compare();
+AST::Base* Parser::stmt() {
 
-  while( this->check() ) {
-    if( this->eat("==") )
-      x = new AST::Expr(ASTKind::Equal, this->ate, x, this->compare());
-    else if( this->eat("!=") )
-      x = new AST::Expr(ASTKind::Not, this->ate,
-            new AST::Expr(ASTKind::Equal, this->ate, x, this->compare()), nullptr);
-    else
-      break;
+  if( this->token->sym == Sym::BraceOpen ) {
+    return this->expectScope();
   }
-  
-  return x;
-}
 
-/*
- * bitAND
- */
-AST::Base* Parser::bitAND() {
-  auto x = this->equality();
-
-  while( this->eat("&") )
-    x = new AST::Expr(ASTKind::BitAND, this->ate, x, this->equality());
-  
-  return x;
-}
+  //
+  // if
+  if( this->eat(Sym::If) ) {
+    auto ast = this->arena.make<AST::If>(this->ate);
 
-/*
- * bitOR
- */
-AST::Base* Parser::bitOR() {
-  auto x = this->bitAND();
+    ast->cond = this->expr();
+    ast->case_true = this->stmt();
 
-  while( this->eat("|") )
-    x = new AST::Expr(ASTKind::BitOR, this->ate, x, this->bitAND());
-  
-  return x;
-}
+    if( this->eat(Sym::Else) ) {
+      ast->case_false = this->stmt();
+    }
 
-/*
- * bitXOR
- */
-AST::Base* Parser::bitXOR() {
-  auto x = this->bitOR();
+    return ast;
+  }
 
-  while( this->eat("^") )
-    x = new AST::Expr(ASTKind::BitXOR, this->ate, x, this->bitOR());
-  
-  return x;
-}
+  //
+  // switch
+  if( this->eat(Sym::Switch) ) {
+    auto ast = this->arena.make<AST::Switch>(this->ate);
 
-/*
- * logAND
- */
-AST::Base* Parser::logAND() {
-  auto x = this->bitXOR();
+    ast->expr = this->expr();
 
-  while( this->eat("&&") )
-    x = new AST::Expr(ASTKind::LogAND, this->ate, x, this->bitXOR());
-  
-  return x;
-}
+    this->expect(Sym::BraceOpen);
 
-/*
- * logOR
- */
-AST::Base* Parser::logOR() {
-  auto x = this->logAND();
+    while( !this->eat(Sym::BraceClose) ) {
+      if( this->eat(Sym::Case) ) {
+        auto to_compare = this->expr();
 
-  while( this->eat("||") )
-    x = new AST::Expr(ASTKind::LogOR, this->ate, x, this->logAND());
-  
-  return x;
-}
+        ast->append(to_compare, this->expectScope());
+      }
+      else if( this->eat(Sym::Default) ) {
+        for( auto&& c : ast->cases ) {
+          if( !c.to_compare ) {
+            Error(this->ate)
+              .setMessage("multiple default cases in switch")
+              .emit()
+              .exit();
+          }
+        }
 
-/*
- * assign
- */
-AST::Base* Parser::assign() {
-  auto x = this->logOR();
+        ast->append(nullptr, this->expectScope());
+      }
+      else {
+        Error(this->token)
+          .setMessage("expected 'case' or 'default'")
+          .emit()
+          .exit();
+      }
+    }
 
-  if( this->eat("=") )
-    x = new AST::Expr(ASTKind::Assignment, this->ate, x, this->assign());
-  
-  return x;
-}
+    return ast;
+  }
 
-/*
- * expr
- */
-AST::Base* Parser::expr() {
-  return this->assign();
-}
+  //
+  // loop
+  if( this->eat(Sym::Loop) ) {
+    auto ast = this->arena.make<AST::While>(this->ate, ASTKind::Loop);
 
-/*
- * stmt
- */
-AST::Base* Parser::stmt() {
+    ast->code = this->loopBody();
 
-  if( this->token->str == "{" ) {
-    return this->expectScope();
+    return ast;
   }
 
   //
-  // if
-  if( this->eat("if") ) {
-    auto ast = new AST::If(this->ate);
+  // while
+  if( this->eat(Sym::While) ) {
+    auto ast = this->arena.make<AST::While>(this->ate);
 
     ast->cond = this->expr();
-    ast->case_true = this->stmt();
-
-    if( this->eat("else") ) {
-      ast->case_false = this->stmt();
-    }
+    ast->code = this->loopBody();
 
     return ast;
   }
 
   //
-  // while
-  if( this->eat("while") ) {
-    auto ast = new AST::While(this->ate);
+  // do-while
+  if( this->eat(Sym::Do) ) {
+    auto ast = this->arena.make<AST::While>(this->ate, ASTKind::DoWhile);
+
+    ast->code = this->loopBody();
+
+    this->expect(Sym::While);
 
     ast->cond = this->expr();
-    ast->code = this->stmt();
+
+    this->expect(Sym::Semicolon);
 
     return ast;
   }
 
   //
   // for
-  if( this->eat("for") ) {
-    auto ast = new AST::For(this->ate);
+  if( this->eat(Sym::For) ) {
+    auto ast = this->arena.make<AST::For>(this->ate);
 
     ast->iter = this->expr();
 
-    this->expect("in");
+    this->expect(Sym::In);
 
     ast->content = this->expr();
 
-    ast->code = this->stmt();
+    ast->code = this->loopBody();
 
     return ast;
   }
 
   //
   // return
-  if( this->eat("return") ) {
-    auto x = new AST::Expr(ASTKind::Return, this->ate, nullptr, nullptr);
+  if( this->eat(Sym::Return) ) {
+    auto x = this->arena.make<AST::Expr>(ASTKind::Return, this->ate, nullptr, nullptr);
 
-    if( !this->eat(";") ) {
+    if( !this->eat(Sym::Semicolon) ) {
       x->left = this->expr();
-      this->expect(";");
+      this->expect(Sym::Semicolon);
     }
 
     return x;
   }
 
   //
-  // break
-  if( this->eat("break") ) {
-    this->expect(";");
-    return new AST::Expr(ASTKind::Break, this->ate, nullptr, nullptr);
-  }
+  // break, continue
+  if( this->eat(Sym::Break) || this->eat(Sym::Continue) ) {
+    auto tok = this->ate;
+
+    if( this->loopDepth == 0 ) {
+      Error(tok)
+        .setMessage("cannot use '" + std::string(tok->str) + "' out side of loop")
+        .emit()
+        .exit();
+    }
 
-  //
-  // continue
-  if( this->eat("continue") ) {
-    this->expect(";");
-    return new AST::Expr(ASTKind::Continue, this->ate, nullptr, nullptr);
+    this->expect(Sym::Semicolon);
+
+    return this->arena.make<AST::Expr>(tok->sym == Sym::Break ? ASTKind::Break : ASTKind::Continue, tok, nullptr, nullptr);
   }
 
   auto x = this->expr();
-  this->expect(";");
+  this->expect(Sym::Semicolon);
   return x;
 }
 
+AST::Base* Parser::loopBody() {
+  this->loopDepth++;
+
+  auto ast = this->stmt();
+
+  this->loopDepth--;
+
+  return ast;
+}
+
 bool Parser::check() {
   return this->token->kind != TokenKind::End;
 }
 
 Token* Parser::next() {
-  this->token = this->token->next;
-  return this->token->prev;
+  return this->token++;
 }
 
-bool Parser::eat(std::string_view s) {
-  if( this->token->str == s ) {
-    this->next();
+bool Parser::eat(SymbolID sym) {
+  if( this->token->sym == sym ) {
+    this->ate = this->next();
     return true;
   }
 
   return false;
 }
 
-Token* Parser::expect(std::string_view s) {
-  if( !this->eat(s) ) {
-    Error err{ this->token->prev ? this->token->prev : this->token };
+Token* Parser::expect(SymbolID sym) {
+  if( !this->eat(sym) ) {
+    auto s = std::string(SymbolTable::getName(sym));
+    auto prev = this->token != this->begin ? this->token - 1 : nullptr;
+
+    Error err{ prev ? prev : this->token };
 
-    if( this->token->prev ) {
-      err.setMessage("expected '" + std::string(s) + "' after this token");
+    if( prev ) {
+      err.setMessage("expected '" + s + "' after this token");
     }
     else {
-      err.setMessage("expected '" + std::string(s) + "' but found '" + std::string(this->token->str) + "'");
+      err.setMessage("expected '" + s + "' but found '" + std::string(this->token->str) + "'");
     }
 
     err.emit().exit();
@@ -638,15 +614,42 @@ Token* Parser::expectIdentifier() {
   return this->ate;
 }
 
+AST::Scope* Parser::parseFunctionBody(AST::Function* func) {
+  if( !func->scope )
+    func->scope = Parser(func->body, *func->constants, *func->arena, true).expectScope();
+
+  return func->scope;
+}
+
+Token* Parser::skipScope() {
+  auto open = this->expect(Sym::BraceOpen);
+
+  for( size_t depth = 1; depth; this->next() ) {
+    if( !this->check() ) {
+      Error(open)
+        .setMessage("scope never closed")
+        .emit()
+        .exit();
+    }
+
+    if( this->token->sym == Sym::BraceOpen )
+      depth++;
+    else if( this->token->sym == Sym::BraceClose )
+      depth--;
+  }
+
+  return open;
+}
+
 AST::Scope* Parser::expectScope() {
-  auto ast = new AST::Scope(this->expect("{"));
+  auto ast = this->arena.make<AST::Scope>(this->expect(Sym::BraceOpen));
 
-  if( this->eat("}") )
+  if( this->eat(Sym::BraceClose) )
     return ast;
 
   bool closed = false;
 
-  while( !(closed = this->eat("}")) )
+  while( !(closed = this->eat(Sym::BraceClose)) )
     ast->list.emplace_back(this->stmt());
 
   if( !closed ) {
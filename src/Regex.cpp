@@ -0,0 +1,1037 @@
+#include <algorithm>
+#include <map>
+#include "Utils.h"
+#include "Regex.h"
+
+namespace metro::regex {
+
+namespace {
+
+// [first, second]
+using Range = std::pair<char16_t, char16_t>;
+
+// sorted and not overlapped
+using Set = std::vector<Range>;
+
+// max count of "{n,m}"
+constexpr int MaxRepeat = 1000;
+
+// max count of instructions
+constexpr size_t MaxProgramSize = 100000;
+
+// max count of DFA states. all states are discarded when exceeded.
+constexpr size_t MaxStates = 10000;
+
+Set normalize(Set set) {
+  Set ret;
+
+  std::sort(set.begin(), set.end());
+
+  for( auto&& r : set ) {
+    if( !ret.empty() && (uint32_t)r.first <= (uint32_t)ret.back().second + 1 )
+      ret.back().second = std::max(ret.back().second, r.second);
+    else
+      ret.emplace_back(r);
+  }
+
+  return ret;
+}
+
+Set negate(Set const& set) {
+  Set ret;
+  uint32_t begin = 0;
+
+  for( auto&& r : set ) {
+    if( begin < r.first )
+      ret.emplace_back(begin, r.first - 1);
+
+    begin = (uint32_t)r.second + 1;
+  }
+
+  if( begin <= 0xFFFF )
+    ret.emplace_back(begin, 0xFFFF);
+
+  return ret;
+}
+
+struct Node {
+  enum Kind {
+    Empty,
+    Chars,
+    Concat,
+    Alt,
+    Repeat,
+    Begin,    // ^
+    End,      // $
+  };
+
+  Kind kind;
+  Set set;                      // Chars
+  std::vector<Node> children;   // Concat, Alt, Repeat (only one)
+  int min = 0;                  // Repeat
+  int max = 0;                  // Repeat (-1 = infinite)
+
+  Node(Kind kind = Empty)
+    : kind(kind)
+  {
+  }
+
+  Node(Set set)
+    : kind(Chars),
+      set(std::move(set))
+  {
+  }
+
+  bool isLiteral() const {
+    return this->kind == Chars && this->set.size() == 1
+      && this->set[0].first == this->set[0].second;
+  }
+};
+
+class Parser {
+public:
+  Parser(std::u16string_view src, std::string& error)
+    : src(src),
+      pos(0),
+      error(error)
+  {
+  }
+
+  Node parse() {
+    auto node = this->alt();
+
+    if( this->ok() && this->pos < this->src.length() )
+      this->fail("unmatched ')'");
+
+    return node;
+  }
+
+private:
+  bool ok() const {
+    return this->error.empty();
+  }
+
+  void fail(std::string const& msg) {
+    if( this->ok() )
+      this->error = msg + " at " + std::to_string(this->pos);
+  }
+
+  bool check() const {
+    return this->ok() && this->pos < this->src.length();
+  }
+
+  char16_t peek(size_t offset = 0) const {
+    return this->pos + offset < this->src.length() ? this->src[this->pos + offset] : 0;
+  }
+
+  bool eat(char16_t c) {
+    if( this->check() && this->peek() == c ) {
+      this->pos++;
+      return true;
+    }
+
+    return false;
+  }
+
+  // a | b
+  Node alt() {
+    auto x = this->concat();
+
+    if( !this->check() || this->peek() != '|' )
+      return x;
+
+    Node node{ Node::Alt };
+
+    node.children.emplace_back(std::move(x));
+
+    while( this->eat('|') )
+      node.children.emplace_back(this->concat());
+
+    return node;
+  }
+
+  // ab
+  Node concat() {
+    Node node{ Node::Concat };
+
+    while( this->check() && this->peek() != '|' && this->peek() != ')' )
+      node.children.emplace_back(this->repeat());
+
+    return node;
+  }
+
+  // a* a+ a? a{n,m}
+  Node repeat() {
+    auto x = this->atom();
+
+    while( this->check() ) {
+      int min, max;
+
+      switch( this->peek() ) {
+        case '*': min = 0, max = -1; this->pos++; break;
+        case '+': min = 1, max = -1; this->pos++; break;
+        case '?': min = 0, max = 1; this->pos++; break;
+
+        case '{':
+          if( !this->braces(min, max) )
+            return x;
+
+          break;
+
+        default:
+          return x;
+      }
+
+      if( x.kind == Node::Begin || x.kind == Node::End ) {
+        this->fail("nothing to repeat");
+        return x;
+      }
+
+      Node node{ Node::Repeat };
+
+      node.min = min;
+      node.max = max;
+      node.children.emplace_back(std::move(x));
+
+      x = std::move(node);
+    }
+
+    return x;
+  }
+
+  //
+  // {n} {n,} {n,m}
+  // returns false if not this form, then "{" is a literal.
+  //
+  bool braces(int& min, int& max) {
+    auto save = this->pos;
+
+    auto number = [&] (int& n) {
+      auto begin = this->pos;
+
+      for( n = 0; this->peek() >= '0' && this->peek() <= '9'; this->pos++ )
+        n = std::min(n * 10 + (this->peek() - '0'), MaxRepeat + 1);
+
+      return this->pos > begin;
+    };
+
+    this->pos++;
+
+    if( !number(min) ) {
+      this->pos = save;
+      return false;
+    }
+
+    max = min;
+
+    if( this->eat(',') && !number(max) )
+      max = -1;
+
+    if( !this->eat('}') ) {
+      this->pos = save;
+      return false;
+    }
+
+    if( min > MaxRepeat || max > MaxRepeat )
+      this->fail("too large repetition");
+    else if( max != -1 && max < min )
+      this->fail("invalid repetition");
+
+    return true;
+  }
+
+  Node atom() {
+    auto c = this->src[this->pos++];
+
+    switch( c ) {
+      case '(': {
+        if( this->peek() == '?' && this->peek(1) == ':' )
+          this->pos += 2;
+
+        auto x = this->alt();
+
+        if( !this->eat(')') )
+          this->fail("missing ')'");
+
+        return x;
+      }
+
+      case '*':
+      case '+':
+      case '?':
+        this->pos--;
+        this->fail("nothing to repeat");
+        return { };
+
+      case '[':
+        return this->set();
+
+      case '.':
+        return negate({ { '\n', '\n' } });
+
+      case '^':
+        return { Node::Begin };
+
+      case '$':
+        return { Node::End };
+
+      case '\\':
+        return this->escape();
+    }
+
+    return Set{ { c, c } };
+  }
+
+  // [abc] [^a-z]
+  Set set() {
+    bool negated = this->eat('^');
+    Set set;
+
+    for( bool first = true;; first = false ) {
+      if( !this->check() ) {
+        this->fail("missing ']'");
+        return { };
+      }
+
+      if( this->peek() == ']' && !first ) {
+        this->pos++;
+        break;
+      }
+
+      Set item;
+
+      if( this->eat('\\') )
+        item = this->escape();
+      else {
+        item = { { this->peek(), this->peek() } };
+        this->pos++;
+      }
+
+      // range
+      if( item.size() == 1 && item[0].first == item[0].second
+        && this->peek() == '-' && this->peek(1) != ']' && this->pos + 1 < this->src.length() ) {
+        this->pos++;
+
+        Set hi;
+
+        if( this->eat('\\') )
+          hi = this->escape();
+        else {
+          hi = { { this->peek(), this->peek() } };
+          this->pos++;
+        }
+
+        if( hi.size() != 1 || hi[0].first != hi[0].second || hi[0].first < item[0].first ) {
+          this->fail("invalid range");
+          return { };
+        }
+
+        item[0].second = hi[0].first;
+      }
+
+      set.insert(set.end(), item.begin(), item.end());
+    }
+
+    set = normalize(std::move(set));
+
+    return negated ? negate(set) : set;
+  }
+
+  // after "\"
+  Set escape() {
+    if( this->pos >= this->src.length() ) {
+      this->fail("trailing '\\'");
+      return { };
+    }
+
+    auto c = this->src[this->pos++];
+
+    auto hex = [&] (size_t digits) -> char16_t {
+      char16_t value = 0;
+
+      for( size_t i = 0; i < digits; i++ ) {
+        auto d = this->peek();
+
+        if( d >= '0' && d <= '9' )
+          value = value * 16 + (d - '0');
+        else if( (d | 0x20) >= 'a' && (d | 0x20) <= 'f' )
+          value = value * 16 + ((d | 0x20) - 'a' + 10);
+        else {
+          this->fail("invalid hex escape");
+          return 0;
+        }
+
+        this->pos++;
+      }
+
+      return value;
+    };
+
+    static Set const digit { { '0', '9' } };
+    static Set const word { { '0', '9' }, { 'A', 'Z' }, { '_', '_' }, { 'a', 'z' } };
+    static Set const space { { '\t', '\r' }, { ' ', ' ' } };
+
+    switch( c ) {
+      case 'd': return digit;
+      case 'D': return negate(digit);
+      case 'w': return word;
+      case 'W': return negate(word);
+      case 's': return space;
+      case 'S': return negate(space);
+
+      case 'n': c = '\n'; break;
+      case 't': c = '\t'; break;
+      case 'r': c = '\r'; break;
+      case 'f': c = '\f'; break;
+      case 'v': c = '\v'; break;
+      case '0': c = 0; break;
+
+      case 'x': c = hex(2); break;
+      case 'u': c = hex(4); break;
+
+      default:
+        if( (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') ) {
+          this->pos--;
+          this->fail("unknown escape");
+          return { };
+        }
+
+        break;
+    }
+
+    return { { c, c } };
+  }
+
+  std::u16string_view src;
+  size_t pos;
+  std::string& error;
+};
+
+//
+// the literal which every match starts with.
+// returns false if the rest of "node" is not literal.
+//
+bool collectPrefix(Node const& node, std::u16string& out) {
+  switch( node.kind ) {
+    case Node::Empty:
+      return true;
+
+    case Node::Chars:
+      if( !node.isLiteral() )
+        return false;
+
+      out += node.set[0].first;
+      return true;
+
+    case Node::Concat:
+      for( auto&& child : node.children ) {
+        if( !collectPrefix(child, out) )
+          return false;
+      }
+
+      return true;
+
+    // at least once
+    case Node::Repeat:
+      if( node.min >= 1 )
+        collectPrefix(node.children[0], out);
+
+      return false;
+  }
+
+  return false;
+}
+
+bool startsWithBegin(Node const& node) {
+  if( node.kind == Node::Concat )
+    return !node.children.empty() && startsWithBegin(node.children[0]);
+
+  return node.kind == Node::Begin;
+}
+
+} // anonymous namespace
+
+struct Pattern::Program {
+  struct Inst {
+    enum Op : uint8_t {
+      Chars,        // x = index of set
+      Split,        // x, y = next
+      Jmp,          // x = next
+      Match,
+      AssertBegin,
+      AssertEnd,
+    };
+
+    Op op;
+    uint32_t x;
+    uint32_t y;
+  };
+
+  std::vector<Inst> insts;
+  std::vector<Set> sets;
+
+  //
+  // equivalence classes of characters.
+  // all characters in same class are matched by same sets.
+  //
+  std::vector<char16_t> bounds;       // the first character of each class (except 0)
+  std::vector<char16_t> classChars;   // a character of each class
+  uint16_t classTable[256];           // class of each latin-1 character
+
+  size_t classOf(char16_t c) const {
+    if( c < 256 )
+      return this->classTable[c];
+
+    return std::upper_bound(this->bounds.begin(), this->bounds.end(), c) - this->bounds.begin();
+  }
+
+  bool contains(uint32_t set, char16_t c) const {
+    auto& ranges = this->sets[set];
+
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), c,
+      [] (char16_t c, Range const& r) { return c < r.first; });
+
+    return it != ranges.begin() && c <= (--it)->second;
+  }
+
+  void makeClasses() {
+    for( auto&& set : this->sets ) {
+      for( auto&& r : set ) {
+        this->bounds.emplace_back(r.first);
+
+        if( r.second < 0xFFFF )
+          this->bounds.emplace_back(r.second + 1);
+      }
+    }
+
+    std::sort(this->bounds.begin(), this->bounds.end());
+
+    this->bounds.erase(std::unique(this->bounds.begin(), this->bounds.end()), this->bounds.end());
+
+    if( !this->bounds.empty() && this->bounds[0] == 0 )
+      this->bounds.erase(this->bounds.begin());
+
+    this->classChars.emplace_back(0);
+    this->classChars.insert(this->classChars.end(), this->bounds.begin(), this->bounds.end());
+
+    for( int c = 0; c < 256; c++ )
+      this->classTable[c] = std::upper_bound(this->bounds.begin(), this->bounds.end(), c) - this->bounds.begin();
+  }
+};
+
+namespace {
+
+//
+// Thompson's construction.
+// if "reversed", the program matches the reversed text.
+//
+class Compiler {
+  using Inst = Pattern::Program::Inst;
+
+public:
+  Compiler(Pattern::Program& prog, bool reversed, std::string& error)
+    : prog(prog),
+      reversed(reversed),
+      error(error)
+  {
+  }
+
+  void compile(Node const& root) {
+    this->node(root);
+    this->emit(Inst::Match);
+  }
+
+private:
+  uint32_t emit(Inst::Op op, uint32_t x = 0, uint32_t y = 0) {
+    if( this->prog.insts.size() >= MaxProgramSize && this->error.empty() )
+      this->error = "pattern is too large";
+
+    this->prog.insts.push_back({ op, x, y });
+
+    return this->prog.insts.size() - 1;
+  }
+
+  uint32_t here() const {
+    return this->prog.insts.size();
+  }
+
+  void node(Node const& node) {
+    if( !this->error.empty() )
+      return;
+
+    switch( node.kind ) {
+      case Node::Empty:
+        break;
+
+      case Node::Chars:
+        this->prog.sets.emplace_back(node.set);
+        this->emit(Inst::Chars, this->prog.sets.size() - 1);
+        break;
+
+      case Node::Concat:
+        if( this->reversed ) {
+          for( auto it = node.children.rbegin(); it != node.children.rend(); it++ )
+            this->node(*it);
+        }
+        else {
+          for( auto&& child : node.children )
+            this->node(child);
+        }
+
+        break;
+
+      //
+      //     split L1, L2
+      // L1: a
+      //     jmp end
+      // L2: b
+      // end:
+      //
+      case Node::Alt: {
+        std::vector<uint32_t> jumps;
+
+        for( size_t i = 0; i < node.children.size(); i++ ) {
+          if( i + 1 == node.children.size() ) {
+            this->node(node.children[i]);
+            break;
+          }
+
+          auto split = this->emit(Inst::Split);
+
+          this->prog.insts[split].x = this->here();
+          this->node(node.children[i]);
+
+          jumps.emplace_back(this->emit(Inst::Jmp));
+          this->prog.insts[split].y = this->here();
+        }
+
+        for( auto&& jmp : jumps )
+          this->prog.insts[jmp].x = this->here();
+
+        break;
+      }
+
+      case Node::Repeat: {
+        auto& child = node.children[0];
+
+        for( int i = 0; i < node.min; i++ )
+          this->node(child);
+
+        //
+        // L:   split L+1, end
+        //      a
+        //      jmp L
+        // end:
+        //
+        if( node.max == -1 ) {
+          auto split = this->emit(Inst::Split);
+
+          this->prog.insts[split].x = this->here();
+          this->node(child);
+          this->emit(Inst::Jmp, split);
+          this->prog.insts[split].y = this->here();
+
+          break;
+        }
+
+        // a? a? ... --> all splits jump to the end
+        std::vector<uint32_t> splits;
+
+        for( int i = node.min; i < node.max; i++ ) {
+          auto split = this->emit(Inst::Split);
+
+          this->prog.insts[split].x = this->here();
+          this->node(child);
+
+          splits.emplace_back(split);
+        }
+
+        for( auto&& split : splits )
+          this->prog.insts[split].y = this->here();
+
+        break;
+      }
+
+      case Node::Begin:
+        this->emit(this->reversed ? Inst::AssertEnd : Inst::AssertBegin);
+        break;
+
+      case Node::End:
+        this->emit(this->reversed ? Inst::AssertBegin : Inst::AssertEnd);
+        break;
+    }
+  }
+
+  Pattern::Program& prog;
+  bool reversed;
+  std::string& error;
+};
+
+} // anonymous namespace
+
+//
+// DFA
+//   built from the program lazily.
+//   a state is the set of instructions where the threads of NFA are.
+//   if "unanchored", threads start at every position.
+//
+class Pattern::DFA {
+  using Inst = Program::Inst;
+
+public:
+  DFA(Program const& prog, bool unanchored)
+    : prog(prog),
+      unanchored(unanchored),
+      marks(prog.insts.size()),
+      generation(0)
+  {
+    this->reset();
+  }
+
+  int start(bool atBegin) {
+    auto& s = this->startStates[atBegin];
+
+    if( s < 0 ) {
+      std::vector<uint32_t> insts;
+
+      this->newSet();
+      this->addThread(insts, 0, atBegin, false);
+
+      s = this->addState(std::move(insts));
+    }
+
+    return this->startStates[atBegin];
+  }
+
+  int next(int state, char16_t c) {
+    auto k = this->prog.classOf(c);
+
+    if( auto to = this->states[state].next[k]; to >= 0 )
+      return to;
+
+    auto ch = this->prog.classChars[k];
+    std::vector<uint32_t> insts;
+
+    this->newSet();
+
+    for( auto&& pc : this->states[state].insts ) {
+      auto& inst = this->prog.insts[pc];
+
+      if( inst.op == Inst::Chars && this->prog.contains(inst.x, ch) )
+        this->addThread(insts, pc + 1, false, false);
+    }
+
+    if( this->unanchored )
+      this->addThread(insts, 0, false, false);
+
+    if( this->states.size() >= MaxStates ) {
+      this->reset();
+      return this->addState(std::move(insts));
+    }
+
+    auto to = this->addState(std::move(insts));
+
+    this->states[state].next[k] = to;
+
+    return to;
+  }
+
+  bool isDead(int state) const {
+    return this->states[state].insts.empty();
+  }
+
+  bool isMatch(int state, bool atEnd) const {
+    return atEnd ? this->states[state].matchAtEnd : this->states[state].match;
+  }
+
+private:
+  struct State {
+    std::vector<uint32_t> insts;  // sorted
+    bool match;                   // Match is in insts
+    bool matchAtEnd;              // Match is reachable at the end of text
+    std::vector<int> next;        // for each class. -1 = not built yet
+  };
+
+  void reset() {
+    this->states.clear();
+    this->indices.clear();
+    this->startStates[0] = this->startStates[1] = -1;
+  }
+
+  void newSet() {
+    if( ++this->generation == 0 ) {
+      std::fill(this->marks.begin(), this->marks.end(), 0);
+      this->generation = 1;
+    }
+  }
+
+  //
+  // add "pc" and instructions reachable without consuming a character.
+  // assertions of the end are kept in the set, unless "atEnd".
+  //
+  void addThread(std::vector<uint32_t>& out, uint32_t pc, bool atBegin, bool atEnd) {
+    this->stack.emplace_back(pc);
+
+    while( !this->stack.empty() ) {
+      pc = this->stack.back();
+      this->stack.pop_back();
+
+      if( this->marks[pc] == this->generation )
+        continue;
+
+      this->marks[pc] = this->generation;
+
+      auto& inst = this->prog.insts[pc];
+
+      switch( inst.op ) {
+        case Inst::Jmp:
+          this->stack.emplace_back(inst.x);
+          break;
+
+        case Inst::Split:
+          this->stack.emplace_back(inst.y);
+          this->stack.emplace_back(inst.x);
+          break;
+
+        case Inst::AssertBegin:
+          if( atBegin )
+            this->stack.emplace_back(pc + 1);
+
+          break;
+
+        case Inst::AssertEnd:
+          if( atEnd )
+            this->stack.emplace_back(pc + 1);
+          else
+            out.emplace_back(pc);
+
+          break;
+
+        default:
+          out.emplace_back(pc);
+          break;
+      }
+    }
+  }
+
+  int addState(std::vector<uint32_t> insts) {
+    std::sort(insts.begin(), insts.end());
+
+    if( auto it = this->indices.find(insts); it != this->indices.end() )
+      return it->second;
+
+    State state;
+
+    auto isMatch = [&] (uint32_t pc) {
+      return this->prog.insts[pc].op == Inst::Match;
+    };
+
+    state.match = std::any_of(insts.begin(), insts.end(), isMatch);
+    state.matchAtEnd = state.match;
+
+    if( !state.match ) {
+      std::vector<uint32_t> atEnd;
+
+      this->newSet();
+
+      for( auto&& pc : insts ) {
+        if( this->prog.insts[pc].op == Inst::AssertEnd )
+          this->addThread(atEnd, pc + 1, false, true);
+      }
+
+      state.matchAtEnd = std::any_of(atEnd.begin(), atEnd.end(), isMatch);
+    }
+
+    state.next.assign(this->prog.classChars.size(), -1);
+    state.insts = insts;
+
+    this->states.emplace_back(std::move(state));
+
+    return this->indices[std::move(insts)] = this->states.size() - 1;
+  }
+
+  Program const& prog;
+  bool unanchored;
+
+  std::vector<State> states;
+  std::map<std::vector<uint32_t>, int> indices;
+  int startStates[2];   // [atBegin]
+
+  std::vector<uint32_t> marks;
+  uint32_t generation;
+  std::vector<uint32_t> stack;
+};
+
+Pattern::Pattern()
+  : anchoredBegin(false)
+{
+}
+
+Pattern::~Pattern()
+{
+}
+
+std::shared_ptr<Pattern> Pattern::compile(std::u16string_view pattern, std::string& error) {
+  error.clear();
+
+  auto root = Parser(pattern, error).parse();
+
+  if( !error.empty() )
+    return nullptr;
+
+  std::shared_ptr<Pattern> ret{ new Pattern };
+
+  ret->forward = std::make_unique<Program>();
+  ret->reverse = std::make_unique<Program>();
+
+  Compiler(*ret->forward, false, error).compile(root);
+  Compiler(*ret->reverse, true, error).compile(root);
+
+  if( !error.empty() )
+    return nullptr;
+
+  ret->forward->makeClasses();
+  ret->reverse->makeClasses();
+
+  ret->forwardDFA = std::make_unique<DFA>(*ret->forward, false);
+  ret->reverseDFA = std::make_unique<DFA>(*ret->reverse, true);
+
+  ret->anchoredBegin = startsWithBegin(root);
+
+  if( !ret->anchoredBegin )
+    collectPrefix(root, ret->prefix);
+
+  return ret;
+}
+
+bool Pattern::match(std::u16string_view str) {
+  return this->longest(str, 0) == (int64_t)str.length();
+}
+
+bool Pattern::search(std::u16string_view str, size_t begin, size_t& matchBegin, size_t& matchEnd) {
+  if( begin > str.length() )
+    return false;
+
+  auto matchAt = [&] (size_t pos) {
+    auto end = this->longest(str, pos);
+
+    if( end < 0 )
+      return false;
+
+    matchBegin = pos;
+    matchEnd = end;
+
+    return true;
+  };
+
+  if( this->anchoredBegin )
+    return begin == 0 && matchAt(0);
+
+  auto from = this->firstCandidate(str, begin);
+
+  if( from == str.npos )
+    return false;
+
+  auto starts = this->startPositions(str, from);
+
+  for( size_t pos = from; pos <= str.length(); pos++ ) {
+    if( starts[pos] )
+      return matchAt(pos);
+  }
+
+  return false;
+}
+
+std::vector<std::pair<size_t, size_t>> Pattern::findAll(std::u16string_view str) {
+  std::vector<std::pair<size_t, size_t>> ret;
+  size_t begin, end;
+
+  if( this->anchoredBegin ) {
+    if( this->search(str, 0, begin, end) )
+      ret.emplace_back(begin, end);
+
+    return ret;
+  }
+
+  auto pos = this->firstCandidate(str, 0);
+
+  if( pos == str.npos )
+    return ret;
+
+  // find the starts of all at once
+  auto starts = this->startPositions(str, pos);
+
+  while( pos <= str.length() ) {
+    if( !starts[pos] ) {
+      pos++;
+      continue;
+    }
+
+    // may scan far beyond the end of the match, see Regex.h
+    begin = pos;
+    end = this->longest(str, pos);
+
+    ret.emplace_back(begin, end);
+
+    // next of empty match
+    pos = end > begin ? end : end + 1;
+  }
+
+  return ret;
+}
+
+//
+// no match starts before the first occurrence of the prefix.
+// the prefix is not tried one by one, since "longest" from each of them
+// may scan the rest of the text.
+//
+size_t Pattern::firstCandidate(std::u16string_view str, size_t begin) {
+  if( this->prefix.empty() )
+    return begin;
+
+  return utils::find_substr(str, this->prefix, begin);
+}
+
+int64_t Pattern::longest(std::u16string_view str, size_t begin) {
+  auto& dfa = *this->forwardDFA;
+  auto state = dfa.start(begin == 0);
+
+  int64_t ret = -1;
+
+  for( size_t pos = begin;; pos++ ) {
+    if( dfa.isMatch(state, pos == str.length()) )
+      ret = pos;
+
+    if( pos == str.length() || dfa.isDead(state) )
+      break;
+
+    state = dfa.next(state, str[pos]);
+  }
+
+  return ret;
+}
+
+//
+// run the reversed program from the end of "str" to "begin".
+// threads start at every position, so the state at a position matches
+// if some match starts at there.
+//
+std::vector<bool> Pattern::startPositions(std::u16string_view str, size_t begin) {
+  auto& dfa = *this->reverseDFA;
+  auto state = dfa.start(true);
+
+  std::vector<bool> ret(str.length() + 1);
+
+  for( size_t pos = str.length();; pos-- ) {
+    ret[pos] = dfa.isMatch(state, pos == 0);
+
+    if( pos == begin )
+      break;
+
+    state = dfa.next(state, str[pos - 1]);
+  }
+
+  return ret;
+}
+
+} // namespace metro::regex
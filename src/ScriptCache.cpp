@@ -0,0 +1,724 @@
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <unistd.h>
+#include "Utils.h"
+#include "ScriptCache.h"
+
+namespace metro::cache {
+
+using namespace objects;
+
+namespace {
+
+constexpr char magic[8] = { 'M', 'E', 'T', 'R', 'O', 'C', 0, 0 };
+
+// change this when the format of tokens or AST is changed.
+constexpr uint32_t formatVersion = 3;
+
+constexpr uint32_t NullIndex = UINT32_MAX;
+constexpr uint8_t NullNode = UINT8_MAX;
+
+struct Header {
+  char      magic[8];
+  char      metroVersion[16];
+  uint32_t  formatVersion;
+  uint32_t  reserved;
+  uint64_t  sourceHash;
+  uint64_t  sourceSize;
+};
+
+class Writer {
+public:
+  Writer(TokenList const& tokens, ConstantPool const& constants)
+    : tokens(tokens),
+      constants(constants)
+  {
+    for( uint32_t i = 0; i < constants.size(); i++ )
+      this->constIndices[constants[i]] = i;
+  }
+
+  template <class T>
+  void write(T const& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    this->buffer.append((char const*)&value, sizeof(T));
+  }
+
+  void writeString(std::string const& str) {
+    this->write((uint32_t)str.length());
+    this->buffer += str;
+  }
+
+  void writeConstants() {
+    this->write((uint32_t)this->constants.size());
+
+    for( auto&& obj : this->constants )
+      this->writeObject(obj);
+  }
+
+  //
+  // ids of identifiers are different in each process,
+  // so write the names of them, and tokens refer the index of the name.
+  //
+  void writeTokens() {
+    std::vector<std::string_view> names;
+    std::unordered_map<SymbolID, SymbolID> localIds;
+
+    for( auto&& tok : this->tokens ) {
+      if( tok.sym >= Sym::_Identifiers && localIds.emplace(tok.sym, Sym::_Identifiers + names.size()).second )
+        names.emplace_back(tok.str);
+    }
+
+    this->write((uint32_t)names.size());
+
+    for( auto&& name : names )
+      this->writeString(std::string(name));
+
+    this->write((uint32_t)this->tokens.size());
+
+    for( auto&& tok : this->tokens ) {
+      this->write((uint8_t)tok.kind);
+      this->write(tok.position);
+      this->write((uint32_t)tok.str.length());
+      this->write(tok.sym >= Sym::_Identifiers ? localIds[tok.sym] : tok.sym);
+
+      if( tok.isLiteral() )
+        this->write(tok.constIndex);
+    }
+  }
+
+  void writeToken(Token const* tok) {
+    this->write(tok ? (uint32_t)(tok - this->tokens.data()) : NullIndex);
+  }
+
+  void writeTokenList(AST::List<Token*> const& list) {
+    this->write((uint32_t)list.size());
+
+    for( auto&& tok : list )
+      this->writeToken(tok);
+  }
+
+  void writeNodeList(AST::List<AST::Base*> const& list) {
+    this->write((uint32_t)list.size());
+
+    for( auto&& ast : list )
+      this->writeNode(ast);
+  }
+
+  void writeObject(Object* obj) {
+    this->write((uint8_t)obj->type.kind);
+
+    switch( obj->type.kind ) {
+      case TypeInfo::Int:
+        this->write(obj->as<Int>()->value);
+        break;
+
+      case TypeInfo::Float:
+        this->write(obj->as<Float>()->value);
+        break;
+
+      case TypeInfo::USize:
+        this->write((uint64_t)obj->as<USize>()->value);
+        break;
+
+      case TypeInfo::Bool:
+        this->write(obj->as<Bool>()->value);
+        break;
+
+      case TypeInfo::Char:
+        this->write(obj->as<Char>()->value);
+        break;
+
+      // UTF-16 as is
+      case TypeInfo::String: {
+        auto& str = obj->as<String>()->value;
+
+        this->write((uint32_t)str.length());
+        this->buffer.append((char const*)str.data(), str.length() * sizeof(char16_t));
+
+        break;
+      }
+    }
+  }
+
+  void writeNode(AST::Base* ast) {
+    if( !ast ) {
+      this->write(NullNode);
+      return;
+    }
+
+    this->write((uint8_t)ast->kind);
+    this->writeToken(ast->token);
+
+    switch( ast->kind ) {
+      // index in the constant pool, or the object itself if not a literal
+      case ASTKind::Value: {
+        auto obj = ast->as<AST::Value>()->object;
+
+        if( auto it = this->constIndices.find(obj); it != this->constIndices.end() )
+          this->write(it->second);
+        else {
+          this->write(NullIndex);
+          this->writeObject(obj);
+        }
+
+        break;
+      }
+
+      case ASTKind::Variable:
+        break;
+
+      case ASTKind::CallFunc:
+      case ASTKind::New: {
+        auto x = ast->as<AST::CallFunc>();
+
+        this->writeToken(x->nameToken);
+        this->writeNodeList(x->arguments);
+        break;
+      }
+
+      case ASTKind::Array:
+      case ASTKind::Tuple:
+        this->writeNodeList(ast->as<AST::Array>()->elements);
+        break;
+
+      case ASTKind::Scope:
+        this->writeNodeList(ast->as<AST::Scope>()->list);
+        break;
+
+      case ASTKind::If: {
+        auto x = ast->as<AST::If>();
+
+        this->writeNode(x->cond);
+        this->writeNode(x->case_true);
+        this->writeNode(x->case_false);
+        break;
+      }
+
+      case ASTKind::Switch: {
+        auto x = ast->as<AST::Switch>();
+
+        this->writeNode(x->expr);
+        this->write((uint32_t)x->cases.size());
+
+        for( auto&& c : x->cases ) {
+          this->writeNode(c.to_compare);
+          this->writeNode(c.scope);
+        }
+
+        break;
+      }
+
+      case ASTKind::Loop:
+      case ASTKind::While:
+      case ASTKind::DoWhile: {
+        auto x = ast->as<AST::While>();
+
+        this->writeNode(x->cond);
+        this->writeNode(x->code);
+        break;
+      }
+
+      case ASTKind::For: {
+        auto x = ast->as<AST::For>();
+
+        this->writeNode(x->iter);
+        this->writeNode(x->content);
+        this->writeNode(x->code);
+        break;
+      }
+
+      case ASTKind::Function: {
+        auto x = ast->as<AST::Function>();
+
+        this->writeToken(x->name_token);
+        this->writeTokenList(x->arguments);
+        this->writeToken(x->body);
+        this->writeNode(x->scope);
+        break;
+      }
+
+      case ASTKind::Enum:
+        this->writeToken(ast->as<AST::Enum>()->nameToken);
+        this->writeTokenList(ast->as<AST::Enum>()->enumerators);
+        break;
+
+      case ASTKind::Struct:
+        this->writeToken(ast->as<AST::Struct>()->nameToken);
+        this->writeTokenList(ast->as<AST::Struct>()->members);
+        break;
+
+      // expressions, return, break, continue
+      default:
+        this->writeNode(ast->as<AST::Expr>()->left);
+        this->writeNode(ast->as<AST::Expr>()->right);
+        break;
+    }
+  }
+
+  std::string buffer;
+
+private:
+  TokenList const& tokens;
+  ConstantPool const& constants;
+
+  std::unordered_map<Object*, uint32_t> constIndices;
+};
+
+//
+// Reader
+//   every read is bounds-checked. "broken" is set if the data is not valid,
+//   and then the result must be discarded.
+//
+class Reader {
+public:
+  Reader(std::string_view data, Metro::ScriptInfo& script)
+    : broken(false),
+      data(data),
+      source(script.source.data),
+      loc(script.source),
+      tokens(script.tokens),
+      constants(script.constants),
+      arena(script.arena)
+  {
+  }
+
+  bool isEnd() const {
+    return this->data.empty();
+  }
+
+  template <class T>
+  T read() {
+    T value { };
+
+    if( this->data.length() < sizeof(T) ) {
+      this->broken = true;
+      return value;
+    }
+
+    std::memcpy(&value, this->data.data(), sizeof(T));
+    this->data.remove_prefix(sizeof(T));
+
+    return value;
+  }
+
+  // count of elements followed, each takes "size" bytes at least
+  uint32_t readCount(size_t size) {
+    auto count = this->read<uint32_t>();
+
+    if( count > this->data.length() / size ) {
+      this->broken = true;
+      return 0;
+    }
+
+    return count;
+  }
+
+  std::string readString() {
+    auto len = this->readCount(1);
+    auto str = std::string(this->data.substr(0, len));
+
+    this->data.remove_prefix(len);
+
+    return str;
+  }
+
+  void readConstants() {
+    auto count = this->readCount(1);
+
+    this->constants.reserve(count);
+
+    for( uint32_t i = 0; i < count && !this->broken; i++ ) {
+      auto obj = this->readObject();
+
+      if( !obj )
+        return;
+
+      obj->noDelete = true;
+      this->constants.emplace_back(obj);
+    }
+  }
+
+  void readTokens() {
+    std::vector<SymbolID> symbols(this->readCount(sizeof(uint32_t)));
+
+    for( auto&& sym : symbols )
+      sym = SymbolTable::get(this->readString());
+
+    auto count = this->readCount(13);
+
+    this->tokens.reserve(count);
+
+    for( uint32_t i = 0; i < count && !this->broken; i++ ) {
+      auto kind = this->read<uint8_t>();
+      auto pos = this->read<uint32_t>();
+      auto len = this->read<uint32_t>();
+      auto sym = this->read<SymbolID>();
+
+      if( kind > (uint8_t)TokenKind::End || pos > this->source.length() || len > this->source.length() - pos ) {
+        this->broken = true;
+        return;
+      }
+
+      if( sym >= Sym::_Identifiers + symbols.size() ) {
+        this->broken = true;
+        return;
+      }
+
+      auto& tok = this->tokens.emplace_back((TokenKind)kind, this->source.substr(pos, len), pos, &this->loc);
+
+      tok.sym = sym >= Sym::_Identifiers ? symbols[sym - Sym::_Identifiers] : sym;
+
+      if( tok.isLiteral() && (tok.constIndex = this->read<uint32_t>()) >= this->constants.size() ) {
+        this->broken = true;
+        return;
+      }
+    }
+
+    if( this->tokens.empty() || this->tokens.back().kind != TokenKind::End )
+      this->broken = true;
+  }
+
+  Token* readToken() {
+    auto index = this->read<uint32_t>();
+
+    if( index == NullIndex )
+      return nullptr;
+
+    if( index >= this->tokens.size() ) {
+      this->broken = true;
+      return nullptr;
+    }
+
+    return &this->tokens[index];
+  }
+
+  // a token must be there
+  Token* expectToken() {
+    auto tok = this->readToken();
+
+    if( !tok )
+      this->broken = true;
+
+    return tok;
+  }
+
+  void readTokenList(AST::List<Token*>& list) {
+    auto count = this->readCount(sizeof(uint32_t));
+
+    for( uint32_t i = 0; i < count && !this->broken; i++ )
+      list.emplace_back(this->expectToken());
+  }
+
+  void readNodeList(AST::List<AST::Base*>& list) {
+    auto count = this->readCount(1);
+
+    for( uint32_t i = 0; i < count && !this->broken; i++ )
+      list.emplace_back(this->readNode());
+  }
+
+  Object* readObject() {
+    switch( this->read<uint8_t>() ) {
+      case TypeInfo::Int:     return new Int(this->read<Int::ValueType>());
+      case TypeInfo::Float:   return new Float(this->read<Float::ValueType>());
+      case TypeInfo::USize:   return new USize(this->read<uint64_t>());
+      case TypeInfo::Bool:    return new Bool(this->read<bool>());
+      case TypeInfo::Char:    return new Char(this->read<char16_t>());
+      case TypeInfo::String: {
+        auto len = this->readCount(sizeof(char16_t));
+        auto str = std::u16string(len, 0);
+
+        for( auto&& ch : str )
+          ch = this->read<char16_t>();
+
+        return new String(str);
+      }
+    }
+
+    this->broken = true;
+    return nullptr;
+  }
+
+  AST::Base* readNode() {
+    auto kind = this->read<uint8_t>();
+
+    if( this->broken || kind == NullNode )
+      return nullptr;
+
+    if( kind > (uint8_t)ASTKind::Struct ) {
+      this->broken = true;
+      return nullptr;
+    }
+
+    auto tok = this->readToken();
+
+    switch( (ASTKind)kind ) {
+      case ASTKind::Value: {
+        auto index = this->read<uint32_t>();
+        Object* obj;
+
+        if( index == NullIndex )
+          obj = this->readObject();
+        else if( index < this->constants.size() )
+          obj = this->constants[index];
+        else {
+          this->broken = true;
+          return nullptr;
+        }
+
+        if( !obj )
+          return nullptr;
+
+        return this->arena.make<AST::Value>(tok, obj);
+      }
+
+      case ASTKind::Variable:
+        if( !tok ) {
+          this->broken = true;
+          return nullptr;
+        }
+
+        return this->arena.make<AST::Variable>(tok);
+
+      case ASTKind::CallFunc:
+      case ASTKind::New: {
+        if( !tok ) {
+          this->broken = true;
+          return nullptr;
+        }
+
+        auto x = this->arena.make<AST::CallFunc>(tok);
+
+        x->kind = (ASTKind)kind;
+
+        if( auto name = this->readToken(); name )
+          x->setNameToken(name);
+
+        this->readNodeList(x->arguments);
+
+        return x;
+      }
+
+      case ASTKind::Array:
+      case ASTKind::Tuple: {
+        auto x = this->arena.make<AST::Array>(tok);
+
+        x->kind = (ASTKind)kind;
+        this->readNodeList(x->elements);
+
+        return x;
+      }
+
+      case ASTKind::Scope: {
+        auto x = this->arena.make<AST::Scope>(tok);
+
+        this->readNodeList(x->list);
+
+        return x;
+      }
+
+      case ASTKind::If: {
+        auto x = this->arena.make<AST::If>(tok);
+
+        x->cond = this->readNode();
+        x->case_true = this->readNode();
+        x->case_false = this->readNode();
+
+        return x;
+      }
+
+      case ASTKind::Switch: {
+        auto x = this->arena.make<AST::Switch>(tok);
+
+        x->expr = this->readNode();
+
+        auto count = this->readCount(2);
+
+        for( uint32_t i = 0; i < count && !this->broken; i++ ) {
+          auto to_compare = this->readNode();
+          x->append(to_compare, this->readNode());
+        }
+
+        return x;
+      }
+
+      case ASTKind::Loop:
+      case ASTKind::While:
+      case ASTKind::DoWhile: {
+        auto x = this->arena.make<AST::While>(tok, (ASTKind)kind);
+
+        x->cond = this->readNode();
+        x->code = this->readNode();
+
+        return x;
+      }
+
+      case ASTKind::For: {
+        auto x = this->arena.make<AST::For>(tok);
+
+        x->iter = this->readNode();
+        x->content = this->readNode();
+        x->code = this->readNode();
+
+        return x;
+      }
+
+      case ASTKind::Function: {
+        auto x = this->arena.make<AST::Function>(tok);
+
+        x->name_token = this->expectToken();
+        this->readTokenList(x->arguments);
+        x->body = this->readToken();
+        x->constants = &this->constants;
+
+        auto scope = this->readNode();
+
+        // not parsed yet
+        if( !scope ) {
+          if( !x->body || x->body->sym != Sym::BraceOpen )
+            this->broken = true;
+
+          return x;
+        }
+
+        if( scope->kind != ASTKind::Scope ) {
+          this->broken = true;
+          return nullptr;
+        }
+
+        x->scope = scope->as<AST::Scope>();
+
+        return x;
+      }
+
+      case ASTKind::Enum:
+      case ASTKind::Struct: {
+        auto name = this->expectToken();
+
+        if( this->broken )
+          return nullptr;
+
+        AST::IdentifierList* x;
+
+        if( kind == (uint8_t)ASTKind::Enum )
+          x = this->arena.make<AST::Enum>(tok, name);
+        else
+          x = this->arena.make<AST::Struct>(tok, name);
+
+        auto count = this->readCount(sizeof(uint32_t));
+
+        for( uint32_t i = 0; i < count && !this->broken; i++ )
+          x->append(this->expectToken());
+
+        return x;
+      }
+
+      case ASTKind::IndexRef: {
+        auto left = this->readNode();
+
+        return this->arena.make<AST::IndexRef>(tok, left, this->readNode());
+      }
+
+      case ASTKind::MemberAccess: {
+        auto left = this->readNode();
+
+        return this->arena.make<AST::MemberAccess>(tok, left, this->readNode());
+      }
+    }
+
+    // expressions, return, break, continue
+    auto left = this->readNode();
+
+    return this->arena.make<AST::Expr>((ASTKind)kind, tok, left, this->readNode());
+  }
+
+  bool broken;
+
+private:
+  std::string_view data;
+  std::string_view source;
+  SourceLoc const& loc;
+
+  TokenList& tokens;
+  ConstantPool& constants;
+  AST::Arena& arena;
+};
+
+void initHeader(Header& header, Metro::ScriptInfo const& script) {
+  std::memcpy(header.magic, magic, sizeof(magic));
+  std::strncpy(header.metroVersion, METRO_VERSION, sizeof(header.metroVersion));
+
+  header.formatVersion = formatVersion;
+  header.sourceHash = script.hash;
+  header.sourceSize = script.source.data.length();
+}
+
+} // anonymous namespace
+
+std::string getCachePath(std::string const& path) {
+  return path + "c";
+}
+
+bool load(Metro::ScriptInfo& script) {
+  utils::MappedFile file{ getCachePath(script.source.path) };
+
+  if( !file.isOpen() || file.view().length() < sizeof(Header) )
+    return false;
+
+  Header header { }, expected { };
+
+  std::memcpy(&header, file.view().data(), sizeof(Header));
+  initHeader(expected, script);
+
+  if( std::memcmp(&header, &expected, sizeof(Header)) != 0 )
+    return false;
+
+  Reader reader{ file.view().substr(sizeof(Header)), script };
+
+  reader.readConstants();
+  reader.readTokens();
+
+  auto ast = reader.readNode();
+
+  if( reader.broken || !reader.isEnd() || !ast || ast->kind != ASTKind::Scope ) {
+    script.tokens.clear();
+    script.constants.clear();
+    return false;
+  }
+
+  script.ast = ast;
+
+  return true;
+}
+
+void save(Metro::ScriptInfo const& script) {
+  Header header { };
+  Writer writer{ script.tokens, script.constants };
+
+  initHeader(header, script);
+
+  writer.write(header);
+  writer.writeConstants();
+  writer.writeTokens();
+  writer.writeNode(script.ast);
+
+  // write to a temporary file and rename it,
+  // so other processes never see the cache partially written.
+  auto path = getCachePath(script.source.path);
+  auto temp = path + "." + std::to_string(getpid());
+
+  auto fp = std::fopen(temp.c_str(), "wb");
+
+  if( !fp )
+    return;
+
+  auto ok = std::fwrite(writer.buffer.data(), 1, writer.buffer.length(), fp) == writer.buffer.length();
+
+  ok = std::fclose(fp) == 0 && ok;
+
+  if( !ok || std::rename(temp.c_str(), path.c_str()) != 0 )
+    std::remove(temp.c_str());
+}
+
+} // namespace metro::cache
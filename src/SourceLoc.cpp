@@ -1,16 +1,51 @@
+#include <algorithm>
+#include <cstring>
 #include "SourceLoc.h"
-#include "Utils.h"
+#include "Metro.h"
 
 namespace metro {
 
-SourceLoc::SourceLoc()
-{
-}
-
 SourceLoc::SourceLoc(std::string const& path)
   : path(path),
-    data(utils::open_text_file(path))
+    file(path),
+    data(file.view())
 {
+  if( !this->file.isOpen() ) {
+    Metro::getInstance()->fatalError("cannot open file '" + path + "'");
+  }
+}
+
+size_t SourceLoc::getLineIndex(size_t pos) const {
+  auto& offsets = this->getLineOffsets();
+
+  return std::upper_bound(offsets.begin(), offsets.end(), pos) - offsets.begin() - 1;
+}
+
+size_t SourceLoc::getLineBegin(size_t index) const {
+  return this->getLineOffsets()[index];
+}
+
+size_t SourceLoc::getLineEnd(size_t index) const {
+  auto& offsets = this->getLineOffsets();
+
+  if( index + 1 < offsets.size() )
+    return offsets[index + 1] - 1;
+
+  return this->data.length();
+}
+
+std::vector<size_t> const& SourceLoc::getLineOffsets() const {
+  std::call_once(this->lineOffsetsFlag, [this] {
+    auto begin = this->data.data();
+    auto end = begin + this->data.length();
+
+    this->lineOffsets.emplace_back(0);
+
+    for( auto p = begin; (p = (char const*)std::memchr(p, '\n', end - p)); )
+      this->lineOffsets.emplace_back(++p - begin);
+  });
+
+  return this->lineOffsets;
 }
 
-} // namespace metro
\ No newline at end of file
+} // namespace metro
@@ -0,0 +1,125 @@
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Symbol.h"
+
+namespace metro {
+
+namespace {
+
+char const* const predefinedNames[] {
+  "",
+
+  // keywords
+  "import",
+  "enum",
+  "struct",
+  "def",
+  "true",
+  "false",
+  "new",
+  "if",
+  "else",
+  "switch",
+  "case",
+  "default",
+  "loop",
+  "while",
+  "do",
+  "for",
+  "in",
+  "return",
+  "break",
+  "continue",
+
+  // punctuaters
+  "<<=",
+  ">>=",
+  "->",
+  "<<",
+  ">>",
+  "<=",
+  ">=",
+  "==",
+  "!=",
+  "..",
+  "&&",
+  "||",
+  "<",
+  ">",
+  "+",
+  "-",
+  "/",
+  "*",
+  "%",
+  "=",
+  ";",
+  ":",
+  ",",
+  ".",
+  "[",
+  "]",
+  "(",
+  ")",
+  "{",
+  "}",
+  "!",
+  "?",
+  "&",
+  "^",
+  "|",
+
+  // identifiers used by the evaluator
+  "abs",
+  "count",
+};
+
+static_assert(std::size(predefinedNames) == Sym::_Identifiers);
+
+struct Table {
+  std::mutex mtx;
+
+  // names are owned by the table, the keys of "ids" refer them.
+  std::deque<std::string> names;
+  std::unordered_map<std::string_view, SymbolID> ids;
+
+  Table() {
+    for( auto&& name : predefinedNames )
+      this->append(name);
+  }
+
+  SymbolID append(std::string_view name) {
+    auto id = (SymbolID)this->names.size();
+
+    this->ids.emplace(this->names.emplace_back(name), id);
+
+    return id;
+  }
+
+  static Table& get() {
+    static Table table;
+    return table;
+  }
+};
+
+} // anonymous namespace
+
+SymbolID SymbolTable::get(std::string_view name) {
+  auto& table = Table::get();
+  std::lock_guard lock{ table.mtx };
+
+  if( auto it = table.ids.find(name); it != table.ids.end() )
+    return it->second;
+
+  return table.append(name);
+}
+
+std::string_view SymbolTable::getName(SymbolID id) {
+  auto& table = Table::get();
+  std::lock_guard lock{ table.mtx };
+
+  return table.names[id];
+}
+
+} // namespace metro
@@ -6,32 +6,14 @@ size_t Token::getEndPos() const {
   return this->position + this->str.length();
 }
 
-Token::Token(TokenKind kind)
+Token::Token(TokenKind kind, std::string_view str, size_t pos, SourceLoc const* source)
   : kind(kind),
-    prev(nullptr),
-    next(nullptr),
-    str(""),
-    position(0),
-    source(nullptr)
-{
-}
-
-Token::Token(TokenKind kind, Token* prev, std::string_view str, size_t pos)
-  : kind(kind),
-    prev(prev),
-    next(nullptr),
+    position((uint32_t)pos),
+    sym(Sym::None),
+    constIndex(0),
     str(str),
-    position(pos),
-    source(nullptr)
-{
-  if( prev )
-    prev->next = this;
-}
-
-Token::~Token()
+    source(source)
 {
-  if( this->next )
-    delete this->next;
 }
 
 } // namespace metro
\ No newline at end of file
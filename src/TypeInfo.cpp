@@ -14,9 +14,15 @@ static char const* names[] {
   "vector",
   "dict",
   "tuple",
+  "pair",
   "range",
   "",   // struct
   "",   // enum
+  "bytes",
+  "string_builder",
+  "regex",
+  "file",
+  "lines",
   "args",
   "any",
 };
@@ -38,10 +44,8 @@ bool TypeInfo::equals(TypeInfo const& type) const {
 
   //
   // enum
-  if( this->kind == TypeInfo::Enumerator ) {
-    if( this->enum_context.ast != type.enum_context.ast || this->enum_context.index != type.enum_context.index )
-      return false;
-  }
+  if( this->kind == TypeInfo::Enumerator && this->ast_enum != type.ast_enum )
+    return false;
 
   //
   // テンプレートパラメーター
@@ -66,12 +70,10 @@ bool TypeInfo::equals(TypeInfo const& type) const {
 std::string TypeInfo::to_string() const {
   switch( this->kind ) {
     case TypeInfo::Enumerator:
-      return
-        this->enum_context.ast->getName()
-          + "." + std::string(this->enum_context.ast->enumerators[this->enum_context.index]->str );
+      return std::string(this->ast_enum->getName());
 
     case TypeInfo::Struct:
-      return this->ast_struct->getName();
+      return std::string(this->ast_struct->getName());
   }
 
   std::string ret = names[static_cast<int>(this->kind)];
@@ -1,23 +1,340 @@
-#include <algorithm>
-#include <fstream>
+#include <bit>
+#include <cerrno>
+#include <random>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "Utils.h"
-#include "Metro.h"
+
+#if defined(__x86_64__)
+  #include <immintrin.h>
+#endif
 
 namespace metro::utils {
 
-std::string open_text_file(std::string const& path) {
-  std::ifstream ifs{ path };
+MappedFile::MappedFile(std::string const& path)
+  : opened(false),
+    data(nullptr),
+    size(0)
+{
+  auto fd = ::open(path.c_str(), O_RDONLY);
+
+  if( fd < 0 )
+    return;
+
+  struct stat st;
+
+  if( ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) ) {
+    this->size = (size_t)st.st_size;
+
+    // mmap can't map an empty file
+    if( this->size == 0 )
+      this->opened = true;
+    else if( auto p = ::mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0); p != MAP_FAILED ) {
+      this->data = p;
+      this->opened = true;
+    }
+  }
+
+  ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+  if( this->data )
+    ::munmap(this->data, this->size);
+}
+
+LineReader::LineReader(int fd)
+  : fd(fd),
+    buffer(BufferSize),
+    begin(0),
+    end(0),
+    eof(false)
+{
+}
+
+bool LineReader::next(std::string_view& line) {
+  size_t scanned = this->begin;
+
+  while( true ) {
+    auto p = (char*)std::memchr(this->buffer.data() + scanned, '\n', this->end - scanned);
+
+    if( p ) {
+      size_t len = p - (this->buffer.data() + this->begin);
+
+      line = { this->buffer.data() + this->begin, len };
+      this->begin += len + 1;
+
+      break;
+    }
+
+    // last line without '\n'
+    if( this->eof ) {
+      if( this->begin == this->end )
+        return false;
+
+      line = { this->buffer.data() + this->begin, this->end - this->begin };
+      this->begin = this->end;
+
+      break;
+    }
+
+    scanned = this->end - this->begin;
+
+    this->fill();
+  }
+
+  if( !line.empty() && line.back() == '\r' )
+    line.remove_suffix(1);
+
+  return true;
+}
+
+//
+// move the unread data to the front, and read the rest.
+// the buffer is extended if a line doesn't fit in.
+//
+bool LineReader::fill() {
+  std::memmove(this->buffer.data(), this->buffer.data() + this->begin, this->end - this->begin);
+
+  this->end -= this->begin;
+  this->begin = 0;
+
+  if( this->end == this->buffer.size() )
+    this->buffer.resize(this->buffer.size() * 2);
+
+  auto n = ::read(this->fd, this->buffer.data() + this->end, this->buffer.size() - this->end);
+
+  if( n < 0 && errno == EINTR )
+    return true;
+
+  if( n <= 0 ) {
+    this->eof = true;
+    return false;
+  }
+
+  this->end += n;
+
+  return true;
+}
+
+std::u16string decode_utf8(std::string_view str) {
+  std::u16string ret;
+
+  ret.reserve(str.length());
+
+  for( size_t i = 0; i < str.length(); ) {
+    char32_t cp = (uint8_t)str[i++];
+
+    if( cp >= 0x80 ) {
+      size_t count = cp >= 0xF0 ? 3 : cp >= 0xE0 ? 2 : 1;
+
+      if( cp < 0xC0 || cp >= 0xF8 || i + count > str.length() ) {
+        ret += u'\uFFFD';
+        continue;
+      }
+
+      cp &= 0x3F >> count;
+
+      for( size_t k = 0; k < count; k++ ) {
+        if( (str[i] & 0xC0) != 0x80 ) {
+          cp = 0xFFFD;
+          break;
+        }
+
+        cp = (cp << 6) | (str[i++] & 0x3F);
+      }
+    }
+
+    // surrogate pair
+    if( cp >= 0x10000 ) {
+      cp -= 0x10000;
+      ret += (char16_t)(0xD800 + (cp >> 10));
+      ret += (char16_t)(0xDC00 + (cp & 0x3FF));
+    }
+    else
+      ret += (char16_t)cp;
+  }
+
+  return ret;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+static size_t find_substr_avx2(std::u16string_view str, std::u16string_view needle) {
+  auto const m = needle.length();
+  auto const first = _mm256_set1_epi16((short)needle.front());
+  auto const last = _mm256_set1_epi16((short)needle.back());
+
+  size_t i = 0;
+
+  for( ; i + m - 1 + 16 <= str.length(); i += 16 ) {
+    auto a = _mm256_loadu_si256((__m256i const*)(str.data() + i));
+    auto b = _mm256_loadu_si256((__m256i const*)(str.data() + i + m - 1));
+
+    // 2 bits for each character
+    auto mask = (uint32_t)_mm256_movemask_epi8(
+      _mm256_and_si256(_mm256_cmpeq_epi16(a, first), _mm256_cmpeq_epi16(b, last)));
 
-  if( ifs.fail() ) {
-    Metro::getInstance()->fatalError("cannot open file '" + path + "'");
+    while( mask ) {
+      auto bit = std::countr_zero(mask);
+      auto pos = i + bit / 2;
+
+      if( m <= 2 || std::memcmp(str.data() + pos + 1, needle.data() + 1, (m - 2) * sizeof(char16_t)) == 0 )
+        return pos;
+
+      mask &= ~(3u << bit);
+    }
+  }
+
+  if( auto pos = str.substr(i).find(needle); pos != str.npos )
+    return i + pos;
+
+  return str.npos;
+}
+#endif
+
+size_t find_substr(std::u16string_view str, std::u16string_view needle, size_t begin) {
+  if( begin > str.length() || str.length() - begin < needle.length() )
+    return str.npos;
+
+  if( needle.empty() )
+    return begin;
+
+#if defined(__x86_64__)
+  static bool const hasAVX2 = __builtin_cpu_supports("avx2");
+
+  if( hasAVX2 ) {
+    auto pos = find_substr_avx2(str.substr(begin), needle);
+
+    return pos == str.npos ? pos : begin + pos;
   }
+#endif
 
-  std::string ret, line;
+  return str.find(needle, begin);
+}
+
+Random::Random(uint64_t seed) {
+  this->seed(seed);
+}
 
-  while( std::getline(ifs, line) )
-    ret += line + '\n';
+//
+// fill the state by splitmix64, so that any seed (even 0) is usable.
+//
+void Random::seed(uint64_t seed) {
+  for( auto&& s : this->state ) {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+
+    s = z ^ (z >> 31);
+  }
+}
+
+uint64_t Random::next() {
+  auto& s = this->state;
+
+  uint64_t ret = std::rotl(s[1] * 5, 7) * 9;
+  uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+
+  s[2] ^= t;
+  s[3] = std::rotl(s[3], 45);
 
   return ret;
 }
 
+//
+// Lemire's nearly divisionless method.
+//
+uint64_t Random::nextBelow(uint64_t bound) {
+  auto m = (unsigned __int128)this->next() * bound;
+
+  if( (uint64_t)m < bound ) {
+    uint64_t threshold = -bound % bound;
+
+    while( (uint64_t)m < threshold )
+      m = (unsigned __int128)this->next() * bound;
+  }
+
+  return (uint64_t)(m >> 64);
+}
+
+double Random::nextDouble() {
+  // upper 53 bits
+  return (this->next() >> 11) * 0x1.0p-53;
+}
+
+Random& Random::get() {
+  thread_local Random random{ ((uint64_t)std::random_device{ }() << 32) ^ std::random_device{ }() };
+
+  return random;
+}
+
+void radix_sort(uint64_t* keys, size_t* values, size_t count) {
+  std::vector<uint64_t> temp(count);
+  std::vector<size_t> tempValues(count);
+  std::vector<size_t> histogram(8 * 256);
+
+  // count all digits in one pass
+  for( size_t i = 0; i < count; i++ ) {
+    for( size_t d = 0; d < 8; d++ )
+      histogram[d * 256 + ((keys[i] >> (d * 8)) & 0xFF)]++;
+  }
+
+  auto src = keys;
+  auto dest = temp.data();
+  auto srcValues = values;
+  auto destValues = tempValues.data();
+
+  for( size_t d = 0; d < 8; d++ ) {
+    auto hist = &histogram[d * 256];
+
+    // all keys have same digit
+    if( count == 0 || hist[(keys[0] >> (d * 8)) & 0xFF] == count )
+      continue;
+
+    size_t offset = 0;
+
+    for( size_t i = 0; i < 256; i++ ) {
+      auto n = hist[i];
+      hist[i] = offset;
+      offset += n;
+    }
+
+    for( size_t i = 0; i < count; i++ ) {
+      auto to = hist[(src[i] >> (d * 8)) & 0xFF]++;
+
+      dest[to] = src[i];
+      destValues[to] = srcValues[i];
+    }
+
+    std::swap(src, dest);
+    std::swap(srcValues, destValues);
+  }
+
+  if( src != keys ) {
+    std::memcpy(keys, src, count * sizeof(uint64_t));
+    std::memcpy(values, srcValues, count * sizeof(size_t));
+  }
+}
+
+uint64_t hash(std::string_view data) {
+  uint64_t h = 0xcbf29ce484222325;
+
+  for( auto&& c : data ) {
+    h ^= (uint8_t)c;
+    h *= 0x100000001b3;
+  }
+
+  return h;
+}
+
 } // namespace metro::utils
\ No newline at end of file